@@ -1 +0,0 @@
-../src/abstraction/synchronizer_test.cc
\ No newline at end of file
@@ -0,0 +1,52 @@
+// EPOS Producer/Consumer Application
+
+// The producer and the consumer hand characters over through a bounded,
+// lock-free ring (see utility/ring.h). They only block on a semaphore when
+// the ring is full or empty.
+
+#include <utility/ostream.h>
+#include <utility/ring.h>
+#include <thread.h>
+#include <semaphore.h>
+#include <alarm.h>
+
+using namespace EPOS;
+
+const int iterations = 100;
+
+OStream cout;
+
+const int BUF_SIZE = 16;
+Blocking_Queue<SPSC_Ring<char, BUF_SIZE>, Semaphore> buffer;
+
+int consumer()
+{
+    for(int i = 0; i < iterations; i++) {
+        char c = buffer.remove();
+        cout << "C<-" << c << "\t";
+        Alarm::delay(5000);
+    }
+
+    return 0;
+}
+
+int main()
+{
+    Thread * cons = new Thread(&consumer);
+
+    // producer
+    for(int i = 0; i < iterations; i++) {
+        Alarm::delay(5000);
+        char c = 'a' + (i % BUF_SIZE);
+        buffer.insert(c);
+        cout << "P->" << c << "\t";
+    }
+
+    cons->join();
+
+    cout << "The end!" << endl;
+
+    delete cons;
+
+    return 0;
+}
@@ -0,0 +1,235 @@
+// EPOS Timer and Alarm Microbenchmarks
+
+// Reports min/avg/p99 in TSC cycles for:
+//   - Alarm creation (insertion) and cancel() with 10, 100 and 1000 alarms pending
+//   - the duration of timer interrupts (ticks), seen as gaps in a loop that
+//     reads the TSC, with no alarms and with 1000 alarms pending
+//   - Alarm::delay() wake-up error (measured minus requested time)
+//   - Chronometer and Clock overhead
+// Run with "make APPLICATION=timer_bench". The configuration measured (4 CPUs,
+// high-resolution alarms, no tracing) is set in timer_bench_traits.h; change
+// Traits<Alarm>::high_resolution there to measure tick-based alarms.
+
+#include <utility/ostream.h>
+#include <alarm.h>
+#include <chronometer.h>
+#include <clock.h>
+
+using namespace EPOS;
+
+typedef TSC::Time_Stamp Time_Stamp;
+
+const unsigned int SAMPLES = 1000;
+const unsigned int MAX_PENDING = 1000;
+const unsigned int FAR_AWAY = 3600000000U; // an hour, so pending alarms never expire during the benchmark
+const Time_Stamp GAP = 1000; // cycles between two TSC reads taken as an interrupt
+
+OStream cout;
+
+class Samples
+{
+public:
+    Samples(): _n(0) {}
+
+    void clear() { _n = 0; }
+    void add(const Time_Stamp & s) { if(_n < SAMPLES) _sample[_n++] = s; }
+    unsigned int size() const { return _n; }
+
+    void report(const char * name, unsigned int param = 0) {
+        cout << name;
+        if(param)
+            cout << "(" << param << ")";
+        if(!_n) {
+            cout << ": no samples" << endl;
+            return;
+        }
+
+        // Insertion sort: samples are few and mostly in order
+        for(unsigned int i = 1; i < _n; i++) {
+            Time_Stamp s = _sample[i];
+            unsigned int j = i;
+            for(; j && (_sample[j - 1] > s); j--)
+                _sample[j] = _sample[j - 1];
+            _sample[j] = s;
+        }
+
+        Time_Stamp sum = 0;
+        for(unsigned int i = 0; i < _n; i++)
+            sum += _sample[i];
+
+        cout << ": n=" << _n << ", min=" << _sample[0] << ", avg=" << sum / _n << ", p99=" << _sample[(_n * 99) / 100] << endl;
+    }
+
+private:
+    unsigned int _n;
+    Time_Stamp _sample[SAMPLES];
+};
+
+Samples samples;
+
+void nothing() {}
+Function_Handler handler(&nothing);
+
+char pending_storage[MAX_PENDING][sizeof(Alarm)] __attribute__((aligned(8)));
+char probe_storage[sizeof(Alarm)] __attribute__((aligned(8)));
+
+Alarm * pending(unsigned int i) { return reinterpret_cast<Alarm *>(&pending_storage[i][0]); }
+
+
+// Arms alarms until "n" are pending (alarms in the storage are kept from one call to the next)
+void fill(unsigned int n)
+{
+    static unsigned int armed;
+
+    for(; armed < n; armed++)
+        new (&pending_storage[armed][0]) Alarm(FAR_AWAY + armed * 1000, &handler, 1);
+}
+
+void empty()
+{
+    for(unsigned int i = 0; i < MAX_PENDING; i++)
+        pending(i)->cancel();
+}
+
+void rearm()
+{
+    for(unsigned int i = 0; i < MAX_PENDING; i++)
+        pending(i)->reset();
+}
+
+
+void insert_and_cancel()
+{
+    const unsigned int levels[] = { 10, 100, 1000 };
+
+    for(unsigned int l = 0; l < sizeof(levels) / sizeof(unsigned int); l++) {
+        fill(levels[l]);
+
+        Samples cancel;
+        samples.clear();
+        for(unsigned int i = 0; i < SAMPLES; i++) {
+            Time_Stamp t0 = TSC::time_stamp();
+            Alarm * probe = new (&probe_storage[0]) Alarm(FAR_AWAY + i, &handler, 1);
+            Time_Stamp t1 = TSC::time_stamp();
+            probe->cancel();
+            Time_Stamp t2 = TSC::time_stamp();
+            probe->~Alarm();
+
+            samples.add(t1 - t0);
+            cancel.add(t2 - t1);
+        }
+        samples.report("Alarm insert", levels[l]);
+        cancel.report("Alarm cancel", levels[l]);
+    }
+}
+
+
+// Spins for 200 ms reading the TSC; every gap longer than GAP is an interrupt
+void ticks(const char * name, unsigned int param)
+{
+    samples.clear();
+
+    Time_Stamp end = TSC::time_stamp() + static_cast<Time_Stamp>(TSC::frequency()) / 5;
+    for(Time_Stamp last = TSC::time_stamp(), now; (now = TSC::time_stamp()) < end; last = now)
+        if(now - last > GAP)
+            samples.add(now - last);
+
+    samples.report(name, param);
+}
+
+
+void delay_error()
+{
+    const unsigned int times[] = { 1000, 10000, 50000 };
+    const unsigned int rounds[] = { 100, 50, 20 };
+
+    for(unsigned int t = 0; t < sizeof(times) / sizeof(unsigned int); t++) {
+        Time_Stamp requested = static_cast<Time_Stamp>(times[t]) * TSC::frequency() / 1000000;
+
+        Samples early;
+        samples.clear();
+        for(unsigned int i = 0; i < rounds[t]; i++) {
+            Time_Stamp t0 = TSC::time_stamp();
+            Alarm::delay(times[t]);
+            Time_Stamp elapsed = TSC::time_stamp() - t0;
+
+            if(elapsed >= requested)
+                samples.add(elapsed - requested);
+            else
+                early.add(requested - elapsed);
+        }
+        samples.report("Alarm::delay late by", times[t]);
+        if(early.size())
+            early.report("Alarm::delay early by", times[t]);
+    }
+}
+
+
+void chronometer_overhead()
+{
+    Chronometer chrono;
+
+    samples.clear();
+    for(unsigned int i = 0; i < SAMPLES; i++) {
+        chrono.reset();
+        Time_Stamp t0 = TSC::time_stamp();
+        chrono.start();
+        chrono.stop();
+        Time_Stamp t1 = TSC::time_stamp();
+        samples.add(t1 - t0);
+    }
+    samples.report("Chronometer start+stop");
+
+    samples.clear();
+    volatile Chronometer::Microsecond us;
+    for(unsigned int i = 0; i < SAMPLES; i++) {
+        Time_Stamp t0 = TSC::time_stamp();
+        us = chrono.read();
+        Time_Stamp t1 = TSC::time_stamp();
+        samples.add(t1 - t0);
+    }
+    samples.report("Chronometer read");
+
+    samples.clear();
+    volatile Clock::Nanosecond ns;
+    for(unsigned int i = 0; i < SAMPLES; i++) {
+        Time_Stamp t0 = TSC::time_stamp();
+        ns = Clock::now();
+        Time_Stamp t1 = TSC::time_stamp();
+        samples.add(t1 - t0);
+    }
+    samples.report("Clock::now");
+
+    samples.clear();
+    for(unsigned int i = 0; i < SAMPLES; i++) {
+        Time_Stamp t0 = TSC::time_stamp();
+        Time_Stamp t1 = TSC::time_stamp();
+        samples.add(t1 - t0);
+    }
+    samples.report("TSC::time_stamp (baseline)");
+}
+
+
+int main()
+{
+    cout << "Timer and alarm benchmarks (TSC cycles, f=" << TSC::frequency() << " Hz, tick=" << 1000000 / Alarm::frequency() << " us, high_resolution=" << Traits<Alarm>::high_resolution << ")" << endl;
+
+    insert_and_cancel();
+
+    empty();
+    ticks("Tick, no alarms pending", 0);
+    rearm();
+    ticks("Tick, alarms pending", MAX_PENDING);
+    empty();
+
+    delay_error();
+
+    chronometer_overhead();
+
+    for(unsigned int i = 0; i < MAX_PENDING; i++)
+        pending(i)->~Alarm();
+
+    cout << "Done!" << endl;
+
+    return 0;
+}
@@ -0,0 +1,187 @@
+#ifndef __traits_h
+#define __traits_h
+
+#include <system/config.h>
+
+__BEGIN_SYS
+
+// Global Configuration
+template<typename T>
+struct Traits
+{
+    static const bool enabled = true;
+    static const bool debugged = true;
+    static const bool hysterically_debugged = false;
+};
+
+template<> struct Traits<Build>
+{
+    enum {LIBRARY};
+    static const unsigned int MODE = LIBRARY;
+
+    enum {IA32};
+    static const unsigned int ARCHITECTURE = IA32;
+
+    enum {PC};
+    static const unsigned int MACHINE = PC;
+
+    enum {Legacy};
+    static const unsigned int MODEL = Legacy;
+
+    static const unsigned int CPUS = 4; // timer_bench: per-CPU alarm queues and timers, needed by high_resolution
+    static const unsigned int NODES = 1; // > 1 => NETWORKING
+};
+
+
+// Utilities
+template<> struct Traits<Debug>
+{
+    static const bool error   = true;
+    static const bool warning = true;
+    static const bool info    = false;
+    static const bool trace   = false; // timer_bench: tracing would dominate the measured paths
+};
+
+template<> struct Traits<Lists>: public Traits<void>
+{
+    static const bool debugged = hysterically_debugged;
+};
+
+template<> struct Traits<Spin>: public Traits<void>
+{
+    static const bool debugged = hysterically_debugged;
+    static const bool profiled = false; // see utility/lock_profiler.h
+};
+
+template<> struct Traits<Heaps>: public Traits<void>
+{
+    static const bool debugged = hysterically_debugged;
+
+    static const unsigned int SIZE_CLASSES = 8; // 16 to 2048 bytes
+    static const unsigned int SLAB_SIZE = 4096;
+    static const unsigned int MAGAZINE_SIZE = 16; // per CPU and size class (0 disables)
+
+    static const bool statistics = false; // see Heap::stats()
+
+    static const unsigned int GROWTH = 64 * 1024; // minimum growth of multiheap application heaps (0 disables)
+    static const unsigned int REGIONS = 16;       // grown regions tracked for shrinking
+
+    static const bool assert_unlocked = false; // panic on allocations made while Thread::locked() (debugging)
+};
+
+
+// System Parts (mostly to fine control debugging)
+template<> struct Traits<Boot>: public Traits<void>
+{
+};
+
+template<> struct Traits<Setup>: public Traits<void>
+{
+};
+
+template<> struct Traits<Init>: public Traits<void>
+{
+};
+
+
+// Mediators
+template<> struct Traits<Serial_Display>: public Traits<void>
+{
+    static const bool enabled = true;
+    static const int COLUMNS = 80;
+    static const int LINES = 24;
+    static const int TAB_SIZE = 8;
+};
+
+__END_SYS
+
+#include __ARCH_TRAITS_H
+#include __MACH_CONFIG_H
+#include __MACH_TRAITS_H
+
+__BEGIN_SYS
+
+
+// Abstractions
+template<> struct Traits<Application>: public Traits<void>
+{
+    static const unsigned int STACK_SIZE = Traits<Machine>::STACK_SIZE;
+    static const unsigned int HEAP_SIZE = Traits<Machine>::HEAP_SIZE;
+    static const unsigned int MAX_THREADS = Traits<Machine>::MAX_THREADS;
+};
+
+template<> struct Traits<System>: public Traits<void>
+{
+    static const unsigned int mode = Traits<Build>::MODE;
+    static const bool multithread = (Traits<Application>::MAX_THREADS > 1);
+    static const bool multitask = (mode != Traits<Build>::LIBRARY);
+    static const bool multicore = (Traits<Build>::CPUS > 1) && multithread;
+    static const bool multiheap = (mode != Traits<Build>::LIBRARY) || Traits<Scratchpad>::enabled;
+
+    enum {FOREVER = 0, SECOND = 1, MINUTE = 60, HOUR = 3600, DAY = 86400, WEEK = 604800, MONTH = 2592000, YEAR = 31536000};
+    static const unsigned long LIFE_SPAN = 1 * HOUR; // in seconds
+
+    static const bool reboot = true;
+
+    static const unsigned int STACK_SIZE = Traits<Machine>::STACK_SIZE;
+    static const unsigned int HEAP_SIZE = (Traits<Application>::MAX_THREADS + 1) * Traits<Application>::STACK_SIZE;
+};
+
+template<> struct Traits<Thread>: public Traits<void>
+{
+    static const bool smp = Traits<System>::multicore;
+
+    typedef Scheduling_Criteria::CFSAffinity<Thread> Criterion;
+    static const unsigned int QUANTUM = 10000; // us
+    static const unsigned int REBALANCER_QUANTUM = QUANTUM * 5;
+    static const unsigned int ACCOUNTING_MAX_HISTORY = 3;
+
+    static const bool trace_idle = hysterically_debugged;
+};
+
+// template<> struct Traits<Accounting>: public Traits<void>
+// {
+//     static const unsigned int MAX_HISTORY = 10;
+// };
+
+template<> struct Traits<Scheduler<Thread>>: public Traits<void>
+{
+    static const bool debugged = Traits<Thread>::trace_idle || hysterically_debugged;
+};
+
+template<> struct Traits<Address_Space>: public Traits<void>
+{
+    static const bool enabled = Traits<System>::multiheap;
+};
+
+template<> struct Traits<Segment>: public Traits<void>
+{
+    static const bool enabled = Traits<System>::multiheap;
+};
+
+template<> struct Traits<Alarm>: public Traits<void>
+{
+    static const bool visible = hysterically_debugged;
+    static const bool high_resolution = true; // timer_bench: the mode measured (one-shot APIC timers programmed for the nearest alarm deadline, multicore only)
+};
+
+template<> struct Traits<Synchronizer>: public Traits<void>
+{
+    static const bool enabled = Traits<System>::multithread;
+    static const bool profiled = false; // see utility/lock_profiler.h
+};
+
+template<> struct Traits<Futex>: public Traits<void>
+{
+    static const bool enabled = Traits<System>::multithread;
+};
+
+template<> struct Traits<RCU>: public Traits<void>
+{
+    static const bool enabled = Traits<System>::multithread;
+    static const unsigned int DELETERS = 64; // free() falls back to the system heap when they run out
+};
+
+__END_SYS
+
+#endif
@@ -7,7 +7,6 @@
 #include <cpu.h>
 #include <machine.h>
 #include <chronometer.h>
-#include <utility/list.h>
 
 __BEGIN_SYS
 template<typename T> // T should be Time_Stamp, Tick or something like that.
@@ -18,8 +17,36 @@ protected:
 	static const unsigned int MAX_HISTORY = Traits<Thread>::ACCOUNTING_MAX_HISTORY;
 
 public:
-	typedef Simple_List<T> List;
-   	typedef typename List::Element Element;
+	// The last MAX_HISTORY samples, kept in place, since accounting happens
+	// in dispatch(), with the thread lock held, and must not use the heap
+	class History
+	{
+	public:
+		History(): _next(0), _size(0) {}
+
+		void insert(const T & sample) {
+			_sample[_next] = sample;
+			_next = (_next + 1) % MAX_HISTORY;
+			if(_size < MAX_HISTORY)
+				_size++;
+		}
+
+		unsigned int size() const { return _size; }
+
+		T head() const { return _size ? _sample[(_next + MAX_HISTORY - 1) % MAX_HISTORY] : 0; }
+
+		T average() const {
+			T sum = 0;
+			for(unsigned int i = 0; i < _size; i++)
+				sum += _sample[i];
+			return _size ? sum / _size : 0;
+		}
+
+	private:
+		T _sample[MAX_HISTORY];
+		unsigned int _next;
+		unsigned int _size;
+	};
 
 	Accounting() {
 		_last_runtime = 0;
@@ -41,9 +68,9 @@ public:
 		return _last_runtime;
 	}
 
-	void last_runtime(T ts) {
+	void last_runtime(T ts, unsigned int cpu = Machine::cpu_id()) {
 		_last_runtime = ts;
-		_total_runtime[Machine::cpu_id()] += ts;
+		_total_runtime[cpu] += ts;
 	}
 
 	// Runtime related to all CPUs
@@ -51,37 +78,29 @@ public:
 		return _total_runtime[cpu_id];
 	}
 
-	// Wait-time related to the current CPU
-	void wait_cron_start() { 
+	// Wait-time related to the current CPU (cpu, given by the callers that know it, spares the APIC reads)
+	void wait_cron_start(unsigned int cpu = Machine::cpu_id()) { 
 		_wait_cron.reset(); 
-		_wait_cron.start();
+		_wait_cron.start(cpu);
 		_wait_cron_running = true;
 	}
 	
-	void wait_cron_stop() { 
-		_wait_cron.stop(); 
+	void wait_cron_stop(unsigned int cpu = Machine::cpu_id()) { 
+		_wait_cron.stop(cpu); 
 		_wait_cron_running = false;
-		T my_value = _wait_cron.read_ticks();
-		_wait_history.insert_head(new (SYSTEM) Element(&my_value));
-		if(_wait_history.size() >= MAX_HISTORY){
-			_wait_history.remove_tail();
-		}
+		_wait_history.insert(_wait_cron.read_ticks());
 	}
 
-	void runtime_cron_start() { 
+	void runtime_cron_start(unsigned int cpu = Machine::cpu_id()) { 
 		_runtime_cron.reset(); 
-		_runtime_cron.start();
+		_runtime_cron.start(cpu);
 		_runtime_cron_running = true; 
 	}
 	
-	void runtime_cron_stop() { 
-		_runtime_cron.stop(); 
+	void runtime_cron_stop(unsigned int cpu = Machine::cpu_id()) { 
+		_runtime_cron.stop(cpu); 
 		_runtime_cron_running = false;
-		T my_value = _runtime_cron.read_ticks();
-		_runtime_history.insert_head(new (SYSTEM) Element(&my_value));
-		if(_runtime_history.size() >= MAX_HISTORY){
-			_runtime_history.remove_tail();
-		}
+		_runtime_history.insert(_runtime_cron.read_ticks());
 	}
 	
 	void wait_cron_running() { 
@@ -101,35 +120,25 @@ public:
 	}
 
 	// Wait-time history
-	List wait_history() { return _wait_history; }
+	const History & wait_history() { return _wait_history; }
 
-	T wait_history_head() { return _wait_history.head()->object(); }
+	T wait_history_head() { return _wait_history.head(); }
 
 	T wait_history_media(){
-		T media = 0;
-		for(Element* e  = _wait_history.head(); e != 0; e = e->next()){
-			media += *e->object();
-		}
-
-		return media / _wait_history.size();
+		return _wait_history.average();
 	}
 
 	// Runtime history
-	List runtime_history() { 
+	const History & runtime_history() { 
 		return _runtime_history; 
 	}
 
 	T runtime_history_head() { 
-		return _runtime_history.head()->object(); 
+		return _runtime_history.head(); 
 	}
 
 	T runtime_history_media() {
-		T media = 0;
-		for (Element* e = _runtime_history.head(); e; e = e->next()) {
-			media += *e->object();
-		}
-
-		return media / _runtime_history.size();
+		return _runtime_history.average();
 	}	
 
 private:
@@ -137,8 +146,8 @@ private:
 	T _total_runtime[Traits<Build>::CPUS];
 	
 	// Account the history of waits and runs (account only MAX_HISTORY data)
-	List _wait_history;
-	List _runtime_history;
+	History _wait_history;
+	History _runtime_history;
 
 	Chronometer _wait_cron;
 	Chronometer _runtime_cron;
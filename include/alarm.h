@@ -3,7 +3,8 @@
 #ifndef __alarm_h
 #define __alarm_h
 
-#include <utility/queue.h>
+#include <utility/wheel.h>
+#include <utility/list.h>
 #include <utility/handler.h>
 #include <tsc.h>
 #include <rtc.h>
@@ -22,7 +23,23 @@ private:
     typedef TSC::Hertz Hertz;
     typedef Timer::Tick Tick;  
 
-    typedef Relative_Queue<Alarm, Tick> Queue;
+    typedef TSC::Time_Stamp Time_Stamp;
+
+    typedef Timing_Wheel<Alarm, Tick> Queue;
+    typedef List<Alarm> Deferred; // expired alarms whose handlers are yet to run
+    typedef Ordered_List<Alarm, Time_Stamp> Imminent; // high-resolution alarms due before the next tick, by latest expiry
+
+    // In high-resolution mode, alarms are kept with TSC deadlines. They wait
+    // in the timing wheel until the tick before their deadline, then move to
+    // the list of imminent alarms, for which the timer is programmed one-shot.
+    static const bool high_resolution = Traits<System>::multicore && Traits<Alarm>::high_resolution;
+
+    // An alarm with slack may expire up to "slack" after its time, which lets
+    // alarms whose windows overlap expire together. In tick mode, expiries are
+    // rounded up to a multiple of the largest power of two within the slack,
+    // so such alarms meet at common ticks. In high-resolution mode, alarms due
+    // within a tick expire at the tick, and one-shot interrupts are requested
+    // for the end of the earliest window, expiring every alarm already due.
 
 public:
     typedef RTC::Microsecond Microsecond;
@@ -31,9 +48,15 @@ public:
     enum { INFINITE = RTC::INFINITE };
     
 public:
-    Alarm(const Microsecond & time, Handler * handler, int times = 1);
+    Alarm(const Microsecond & time, Handler * handler, int times = 1, const Microsecond & slack = 0);
     ~Alarm();
 
+    void reset() { reset(_time); }
+    void reset(const Microsecond & time);
+    void cancel();
+    void period(const Microsecond & time);
+    Microsecond remaining();
+
     static Hertz frequency() { return _timer->frequency(); }
 
     static void delay(const Microsecond & time);
@@ -49,20 +72,49 @@ private:
         return (time + period() / 2) / period();
     }
 
+    static Time_Stamp cycles(const Microsecond & time) {
+        return static_cast<Time_Stamp>(time) * TSC::frequency() / 1000000;
+    }
+
     static void lock() { Thread::lock(); }
     static void unlock() { Thread::unlock(); }
 
+    bool start();
+    void dequeue();
+    void queue();
+    void arm();
+    static void expire(Alarm * alarm, unsigned int cpu);
+    static void due(unsigned int cpu, const Time_Stamp & now);
+
     static void handler(const IC::Interrupt_Id & i);
+    static void deadline(const IC::Interrupt_Id & i);
+    static void run_deferred();
 
 private:
+    Microsecond _time;
     Tick _ticks;
+    Tick _slack;
+    Tick _due;               // tick mode only: the tick this alarm is due at, before rounding
     Handler * _handler;
     int _times; 
+    int _repeat;             // times to expire after a reset()
     Queue::Element _link;
+    Deferred::Element _deferred_link;
+    unsigned int _cpu;       // the CPU whose queue holds this alarm
+    Deferred * _deferred_in; // the per-CPU list this alarm is pending in, if any
+    unsigned int _runs;      // expirations not handled yet
+    Time_Stamp _deadline;    // high-resolution mode only
+    Time_Stamp _period;
+    Time_Stamp _slack_ts;
+    Imminent::Element _imminent_link;
+    Imminent * _imminent_in;
 
     static Alarm_Timer * _timer;
     static volatile Tick _elapsed;
-    static Queue _request;
+    static Queue _request[Traits<Build>::CPUS];
+    static Deferred _deferred[Traits<Build>::CPUS];
+    static Imminent _imminent[Traits<Build>::CPUS];
+    static Time_Stamp _tick[Traits<Build>::CPUS]; // when each CPU last ticked its queue
 };
 
 
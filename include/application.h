@@ -19,9 +19,16 @@ class Application
     friend void * ::malloc(size_t);
     friend void ::free(void *);
 
+public:
+    // The heap used by malloc() in multiheap mode (see System::heap() otherwise)
+    static Heap * heap() { return _heap; }
+
 private:
     static void init();
 
+    static void * grow(unsigned int * bytes, void ** segment);
+    static void shrink(void * addr, unsigned int bytes, void * segment);
+
 private:
     static char _preheap[sizeof(Heap)];
     static Heap * _heap;
@@ -6,6 +6,8 @@
 #include <system/memory_map.h>
 #include <utility/string.h>
 #include <utility/list.h>
+#include <utility/bitmap.h>
+#include <utility/spin.h>
 #include <utility/debug.h>
 #include <cpu.h>
 #include <mmu.h>
@@ -17,9 +19,28 @@ class IA32_MMU: public MMU_Common<10, 10, 12>
     friend class IA32;
 
 private:
-    typedef Grouping_List<Frame> List;
-
     static const unsigned int PHY_MEM = Memory_Map<Machine>::PHY_MEM;
+    static const unsigned int MEM_BASE = Memory_Map<Machine>::MEM_BASE;
+    static const unsigned int MEM_TOP = Memory_Map<Machine>::MEM_TOP;
+
+    // Physical frames are managed by a binary buddy allocator. Free blocks of
+    // 2^order frames are kept in per-order lists whose elements live in the
+    // first frame of each block, while a bitmap (one region per order) tells
+    // whether the buddy of a block being freed is itself free and can be merged.
+    static const unsigned int FRAMES = (MEM_TOP - MEM_BASE) / sizeof(Frame);
+    static const unsigned int ORDERS = LOG2<FRAMES>::Result + 1;
+
+    // The bitmap layout (see bit()) and ORDERS hold only for a power-of-2 number of frames
+    static_assert((1U << LOG2<FRAMES>::Result) == FRAMES, "MEM_TOP - MEM_BASE must be a power-of-2 number of frames");
+
+    typedef List<Frame> Free_List;
+    typedef Bitmap<FRAMES * 2> Free_Map;
+
+    // Idle threads clear free frames in the background (see zero()) and keep
+    // them in a pool from which calloc() takes single frames without paying
+    // for the memset. Pooled frames are still free memory: alloc() gives them
+    // back to the buddy allocator before failing.
+    static const unsigned int ZEROED_FRAMES = Traits<IA32_MMU>::ZEROED_FRAMES;
 
 public:
     // Page Flags
@@ -316,11 +337,35 @@ public:
         Phy_Addr phy(false);
 
         if(frames) {
-            List::Element * e = _free.search_decrementing(frames);
-            if(e)
-        	phy = e->object() + e->size();
-            else
-        	db<IA32_MMU>(WRN) << "IA32_MMU::alloc() failed!" << endl;
+            bool ints = lock();
+
+            unsigned int o = order(frames);
+            unsigned int i = search(o);
+
+            if((i == ORDERS) && !_zeroed.empty()) {
+                while(!_zeroed.empty())
+                    insert(index(_zeroed.remove_head()->object()), 0);
+                i = search(o);
+            }
+
+            if(i < ORDERS) {
+                unsigned int f = index(_free[i].remove_head()->object());
+                _map.reset(bit(f, i));
+
+                // Split the block down to the requested order, freeing the upper halves
+                while(i > o) {
+                    i--;
+                    insert(f + (1 << i), i);
+                }
+
+                // Return the frames beyond the requested ones
+                release(f + frames, (1 << o) - frames);
+
+                phy = frame(f);
+            } else
+                db<IA32_MMU>(WRN) << "IA32_MMU::alloc() failed!" << endl;
+
+            unlock(ints);
         }
 
         db<IA32_MMU>(TRC) << "IA32_MMU::alloc(frames=" << frames << ") => " << phy << endl;
@@ -329,6 +374,18 @@ public:
     }
 
     static Phy_Addr calloc(unsigned int frames = 1) {
+        if(ZEROED_FRAMES && (frames == 1)) {
+            bool ints = lock();
+            Free_List::Element * e = _zeroed.remove_head();
+            unlock(ints);
+
+            if(e) {
+                Phy_Addr phy = e->object();
+                memset(static_cast<void *>(e), 0, sizeof(Free_List::Element)); // the only part of the frame the pool touched
+                return phy;
+            }
+        }
+
         Phy_Addr phy = alloc(frames);
 
         memset(phy2log(phy), 0, sizeof(Frame) * frames);
@@ -343,13 +400,39 @@ public:
         db<IA32_MMU>(TRC) << "IA32_MMU::free(frame=" << frame << ",n=" << n << ")" << endl;
 
         if(frame && n) {
-            List::Element * e = new (phy2log(frame)) List::Element(frame, n);
-            List::Element * m1, * m2;
-            _free.insert_merging(e, &m1, &m2);
+            bool ints = lock();
+            release(index(frame), n);
+            unlock(ints);
         }
     }
 
-    static unsigned int allocable() { return _free.head() ? _free.head()->size() : 0; }
+    // Clears a free frame into the pool of pre-zeroed frames, returning false
+    // if the pool is full or memory is short. Called by the idle threads, with
+    // interrupts enabled, so the memset is preempted by any other thread.
+    static bool zero() {
+        if(!ZEROED_FRAMES || (_zeroed.size() >= ZEROED_FRAMES) || (allocable() <= 1))
+            return false;
+
+        Phy_Addr phy = alloc(1);
+        if(!phy)
+            return false;
+
+        memset(phy2log(phy), 0, sizeof(Frame));
+
+        bool ints = lock();
+        _zeroed.insert(new (phy2log(phy)) Free_List::Element(phy));
+        unlock(ints);
+
+        return true;
+    }
+
+    // Largest number of contiguous frames a single alloc() can get
+    static unsigned int allocable() {
+        for(int i = ORDERS - 1; i >= 0; i--)
+            if(!_free[i].empty())
+                return 1 << i;
+        return 0;
+    }
 
     static Page_Directory * volatile current() {
         return reinterpret_cast<Page_Directory * volatile>(CPU::pdp());
@@ -374,8 +457,72 @@ private:
 
     static Log_Addr phy2log(const Phy_Addr & phy) { return phy | PHY_MEM; }
 
+    static unsigned int index(const Phy_Addr & frame) { return (static_cast<unsigned int>(frame) - MEM_BASE) / sizeof(Frame); }
+    static Phy_Addr frame(unsigned int index) { return Phy_Addr(MEM_BASE + index * sizeof(Frame)); }
+
+    // Lowest order at or above o with a free block (ORDERS if none)
+    static unsigned int search(unsigned int o) {
+        for(; (o < ORDERS) && _free[o].empty(); o++);
+        return o;
+    }
+
+    // Smallest order whose blocks hold "frames" frames
+    static unsigned int order(unsigned int frames) {
+        unsigned int o = 0;
+        for(; (1U << o) < frames; o++);
+        return o;
+    }
+
+    // Bit telling whether the block of order o starting at frame f is free
+    static unsigned int bit(unsigned int f, unsigned int o) { return FRAMES * 2 - (FRAMES * 2 >> o) + (f >> o); }
+
+    // Frees n frames starting at frame f as the largest aligned blocks that fit
+    static void release(unsigned int f, unsigned int n) {
+        while(n) {
+            unsigned int o = 0;
+            while((o + 1 < ORDERS) && !(f & ((1 << (o + 1)) - 1)) && ((1U << (o + 1)) <= n))
+                o++;
+            insert(f, o);
+            f += 1 << o;
+            n -= 1 << o;
+        }
+    }
+
+    // Inserts the free block of order o at frame f, merging it with its free buddies
+    static void insert(unsigned int f, unsigned int o) {
+        for(; o < ORDERS - 1; o++) {
+            unsigned int b = f ^ (1 << o);
+            if(!_map.test(bit(b, o)))
+                break;
+            _map.reset(bit(b, o));
+            _free[o].remove(reinterpret_cast<Free_List::Element *>(static_cast<void *>(phy2log(frame(b)))));
+            f &= ~(1 << o);
+        }
+
+        Frame * phy = frame(f);
+        _free[o].insert(new (phy2log(frame(f))) Free_List::Element(phy));
+        _map.set(bit(f, o));
+    }
+
+    // Frames are taken by idle threads on all CPUs, so the allocator is locked
+    static bool lock() {
+        bool ints = CPU::int_enabled();
+        CPU::int_disable();
+        _lock.acquire();
+        return ints;
+    }
+
+    static void unlock(bool ints) {
+        _lock.release();
+        if(ints)
+            CPU::int_enable();
+    }
+
 private:
-    static List _free;
+    static Free_List _free[ORDERS];
+    static Free_List _zeroed;
+    static Free_Map _map;
+    static Spin _lock;
     static Page_Directory * _master;
 };
 
@@ -13,6 +13,7 @@ template<> struct Traits<IA32>: public Traits<void>
     static const unsigned int WORD_SIZE         = 32;
     static const unsigned int CLOCK             = 2000000000;
     static const bool unaligned_memory_access   = true;
+    static const unsigned int CACHE_LINE_SIZE   = 64;
 };
 
 template<> struct Traits<IA32_TSC>: public Traits<void>
@@ -21,6 +22,7 @@ template<> struct Traits<IA32_TSC>: public Traits<void>
 
 template<> struct Traits<IA32_MMU>: public Traits<void>
 {
+    static const unsigned int ZEROED_FRAMES = 64; // pre-zeroed frames kept by the idle threads for calloc() (0 disables)
 };
 
 template<> struct Traits<IA32_PMU>: public Traits<void>
@@ -0,0 +1,36 @@
+// EPOS Barrier Abstraction Declarations
+
+#ifndef __barrier_h
+#define __barrier_h
+
+#include <utility/handler.h>
+#include <synchronizer.h>
+
+__BEGIN_SYS
+
+// Reusable barrier for "n" threads. The last thread to arrive advances the
+// generation and releases all waiters at once. If "spin" is not zero, threads
+// poll the generation for up to "spin" iterations before going to sleep,
+// which pays off for short phases on dedicated cores.
+class Barrier: protected Synchronizer_Common
+{
+public:
+    Barrier(unsigned int n, unsigned int spin = 0);
+    ~Barrier();
+
+    // Returns true for exactly one thread per generation (the last to arrive)
+    bool wait();
+
+    unsigned int parties() const { return _parties; }
+    unsigned int generation() const { return _generation; }
+
+private:
+    unsigned int _parties;
+    unsigned int _spin;
+    volatile unsigned int _count;
+    volatile unsigned int _generation;
+};
+
+__END_SYS
+
+#endif
@@ -3,8 +3,7 @@
 #ifndef __chronometer_h
 #define __chronometer_h
 
-#include <tsc.h>
-#include <rtc.h>
+#include <clock.h>
 
 __BEGIN_SYS
 
@@ -15,7 +14,8 @@ private:
 
 public:
     typedef TSC::Hertz Hertz;
-    typedef RTC::Microsecond Microsecond;
+    typedef Clock::Microsecond Microsecond;
+    typedef Clock::Nanosecond Nanosecond;
 
 public:
     Chronometer() : _start(0), _stop(0) {}
@@ -23,19 +23,22 @@ public:
     Hertz frequency() { return tsc.frequency(); }
 
     void reset() { _start = 0; _stop = 0; }
-    void start() { if(_start == 0) _start = tsc.time_stamp(); }
-    void lap() { if(_start != 0) _stop = tsc.time_stamp(); }
-    void stop() { lap(); }
+    // Time stamps come from Clock, so a chronometer can be started and stopped on different CPUs
+    // (pass the current CPU, if known, to spare Clock from looking it up)
+    void start(unsigned int cpu = Machine::cpu_id()) { if(_start == 0) _start = Clock::time_stamp(cpu); }
+    void lap(unsigned int cpu = Machine::cpu_id()) { if(_start != 0) _stop = Clock::time_stamp(cpu); }
+    void stop(unsigned int cpu = Machine::cpu_id()) { lap(cpu); }
 
-    Microsecond read() { return ticks() * 1000000 / frequency(); }
-    Time_Stamp read_ticks() { return ticks(); } 
+    Microsecond read() { return Clock::microseconds(ticks()); }
+    Nanosecond read_ns() { return Clock::nanoseconds(ticks()); }
+    Time_Stamp read_ticks() { return ticks(); }
 
 private:
     Time_Stamp ticks() {
         if(_start == 0)
             return 0;
         if(_stop == 0)
-            return tsc.time_stamp() - _start;
+            return Clock::time_stamp() - _start;
         return _stop - _start;
     }
 
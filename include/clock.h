@@ -1,15 +1,35 @@
 // EPOS Clock Abstraction Declarations
 
+// Clock::now() is a monotonic time in nanoseconds since boot, taken from the
+// TSC. Each CPU records its own TSC at a common rendezvous during boot and
+// subtracts it afterwards, so readings taken on different CPUs are comparable.
+// Time stamps are converted with a precomputed multiplier and shift (the
+// product is split in two 32x32-bit multiplications), never with a division.
+// Wall-clock time still comes from the RTC.
+
 #ifndef __clock_h
 #define __clock_h
 
+#include <tsc.h>
 #include <rtc.h>
+#include <machine.h>
 
 __BEGIN_SYS
 
 class Clock
 {
+    friend class Init_System;
+
+private:
+    struct Scale {
+        unsigned int mult;
+        unsigned int shift;
+    };
+
 public:
+    typedef TSC::Hertz Hertz;
+    typedef TSC::Time_Stamp Time_Stamp;
+    typedef unsigned long long Nanosecond;
     typedef RTC::Microsecond Microsecond;
     typedef RTC::Second Second;
     typedef RTC::Date Date;
@@ -17,12 +37,44 @@ public:
 public:
     Clock() {}
 
-    Microsecond resolution() { return 1000000; }
+    static Nanosecond resolution() { return 1 + 1000000000 / TSC::frequency(); }
+
+    static Nanosecond now() { return nanoseconds(time_stamp()); }
+
+    // TSC of this CPU relative to the boot rendezvous. Machine::cpu_id() reads the APIC,
+    // so callers that already know which CPU they run on should pass it.
+    static Time_Stamp time_stamp(unsigned int cpu = Machine::cpu_id()) { return TSC::time_stamp() - _offset[cpu]; }
 
-    Second now() { return RTC::seconds_since_epoch(); }
+    static Nanosecond nanoseconds(const Time_Stamp & ts) { return scale(ts, _ns); }
+    static Microsecond microseconds(const Time_Stamp & ts) { return scale(ts, _us); }
+
+    Second epoch() { return RTC::seconds_since_epoch(); }
 
     Date date() { return RTC::date(); }
     void date(const Date & d) { return RTC::date(d); }
+
+private:
+    static unsigned long long scale(const Time_Stamp & ts, const Scale & s) {
+        unsigned long long hi = static_cast<unsigned long long>(static_cast<unsigned int>(ts >> 32)) * s.mult;
+        unsigned long long lo = static_cast<unsigned long long>(static_cast<unsigned int>(ts)) * s.mult;
+        hi = (s.shift > 32) ? (hi >> (s.shift - 32)) : (hi << (32 - s.shift));
+        return hi + (lo >> s.shift);
+    }
+
+    // Largest shift whose multiplier still fits in 32 bits
+    static Scale scale(unsigned long long unit, const Hertz & frequency) {
+        Scale s;
+        for(s.shift = 0; !((unit << s.shift) >> 63) && !(((unit << (s.shift + 1)) / frequency) >> 32); s.shift++);
+        s.mult = (unit << s.shift) / frequency;
+        return s;
+    }
+
+    static void init();
+
+private:
+    static Scale _ns;
+    static Scale _us;
+    static Time_Stamp _offset[Traits<Build>::CPUS];
 };
 
 __END_SYS
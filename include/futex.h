@@ -0,0 +1,60 @@
+// EPOS Futex Abstraction Declarations
+
+// Futex offers wait-on-address and wake-by-address primitives, so library
+// synchronizers (locks, latches, channels) can run their fast paths on plain
+// atomics and only reach the scheduler on real contention.
+// Waiters are kept in a hash table keyed by the address they wait on. Each
+// waiter sleeps on a private queue that lives in its own stack frame, thus
+// the table never allocates memory. Threads are marked while they wait on a
+// futex, so a waiting thread that is deleted takes its entry out of the table
+// (see abandon()), since its stack goes with it.
+
+#ifndef __futex_h
+#define __futex_h
+
+#include <utility/hash.h>
+#include <thread.h>
+
+__BEGIN_SYS
+
+class Futex
+{
+    friend class Thread;
+
+private:
+    static const unsigned int BUCKETS = 61;
+
+    typedef Thread::Queue Queue;
+
+    struct Waiter;
+    typedef Hash<Waiter, BUCKETS, unsigned int> Table;
+
+    struct Waiter {
+        Waiter(volatile int * addr): link(this, reinterpret_cast<unsigned int>(addr)) {}
+
+        Queue queue;
+        Table::Element link;
+    };
+
+public:
+    // Blocks the calling thread if *addr still equals "expected".
+    // Returns false (without blocking) if the value had already changed.
+    static bool wait(volatile int * addr, int expected);
+
+    // Wakes up to "n" threads waiting on addr; returns how many were woken.
+    static unsigned int wake(volatile int * addr, unsigned int n = 1);
+    static unsigned int wake_all(volatile int * addr) { return wake(addr, ~0U); }
+
+private:
+    static void lock() { Thread::lock(); }
+    static void unlock() { Thread::unlock(); }
+
+    static void abandon(Thread * thread);
+
+private:
+    static Table _table;
+};
+
+__END_SYS
+
+#endif
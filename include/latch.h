@@ -0,0 +1,47 @@
+// EPOS Latch Abstraction Declarations
+
+#ifndef __latch_h
+#define __latch_h
+
+#include <utility/handler.h>
+#include <synchronizer.h>
+
+__BEGIN_SYS
+
+// Single-use countdown latch. Threads calling wait() block until count_down()
+// has been called enough times to bring the counter to zero, then all of them
+// are released at once. As for Barrier, "spin" enables spin-then-block waiting.
+class Latch: protected Synchronizer_Common
+{
+public:
+    Latch(int count, unsigned int spin = 0);
+    ~Latch();
+
+    void count_down(int n = 1);
+    void wait();
+    bool try_wait() const { return _count <= 0; }
+
+    int count() const { return _count; }
+
+private:
+    unsigned int _spin;
+    volatile int _count;
+};
+
+
+// An event handler that counts down a latch (see handler.h)
+class Latch_Handler: public Handler
+{
+public:
+    Latch_Handler(Latch * h) : _handler(h) {}
+    ~Latch_Handler() {}
+
+    void operator()() { _handler->count_down(); }
+
+private:
+    Latch * _handler;
+};
+
+__END_SYS
+
+#endif
@@ -253,54 +253,181 @@ protected:
     typedef IF<Traits<System>::multicore, APIC_Timer, i8253>::Result Engine;
     typedef Engine::Count Count;
     typedef IC::Interrupt_Id Interrupt_Id;
+    typedef TSC::Time_Stamp Time_Stamp;
 
     static const unsigned int CHANNELS = 4;
     static const unsigned int FREQUENCY = Traits<PC_Timer>::FREQUENCY;
 
+    // In high-resolution mode, the APIC timer of each CPU runs one-shot. It is
+    // programmed for the next periodic tick (kept in TSC time stamps, so the
+    // channels still see ticks at FREQUENCY) or for the nearest deadline asked
+    // through deadline(), whichever comes first.
+    static const bool high_resolution = Traits<System>::multicore && Traits<Alarm>::high_resolution;
+    static const Count MIN_COUNT = 32; // APIC_Timer counts in steps of 16 bus cycles
+
+    // Each CPU keeps its channels in a binary min-heap ordered by the tick
+    // they are due at, so an interrupt with no channel due costs a single
+    // comparison. A CPU only touches its own heap, from the interrupt handler
+    // or with interrupts disabled. Installing or removing a timer marks all
+    // heaps stale, and each CPU rebuilds its own at its next due channel (or
+    // at the next tick, if it has none).
+    class Multiplexer
+    {
+    private:
+        struct Entry {
+            Tick due;
+            unsigned int channel;
+        };
+
+    public:
+        Multiplexer(): _now(0), _next(1), _size(0), _stale(1) {}
+
+        // Counts a tick and tells whether any channel may be due
+        bool tick() { return static_cast<long>(++_now - _next) >= 0; }
+
+        void invalidate() { _stale = 1; }
+
+        // Tells whether the heap must be rebuilt, clearing the mark atomically (so it is not lost to a concurrent invalidate())
+        bool validate() { return _stale && (CPU::cas(_stale, 1, 0) == 1); }
+
+        void clear() { _size = 0; }
+
+        void insert(unsigned int channel, const Tick & ticks) {
+            unsigned int i = _size++;
+            _heap[i].due = _now + ticks;
+            _heap[i].channel = channel;
+            up(i);
+            _next = _heap[0].due;
+        }
+
+        bool remove(unsigned int channel) {
+            unsigned int i = search(channel);
+            if(i == _size)
+                return false;
+            _heap[i] = _heap[--_size];
+            if(i < _size) {
+                up(i);
+                down(i);
+            }
+            _next = _size ? _heap[0].due : _now + 1;
+            return true;
+        }
+
+        // Removes and returns a channel that is due, or -1 if none is
+        int expired() {
+            if(!_size || (static_cast<long>(_now - _heap[0].due) < 0)) {
+                _next = _size ? _heap[0].due : _now + 1;
+                return -1;
+            }
+            unsigned int channel = _heap[0].channel;
+            _heap[0] = _heap[--_size];
+            down(0);
+            return channel;
+        }
+
+        // Ticks left for a channel, or "otherwise" if it is not in the heap
+        Tick remaining(unsigned int channel, const Tick & otherwise) const {
+            unsigned int i = search(channel);
+            return (i == _size) ? otherwise : _heap[i].due - _now;
+        }
+
+    private:
+        static bool before(const Entry & a, const Entry & b) {
+            long d = static_cast<long>(a.due - b.due);
+            return (d < 0) || (!d && (a.channel < b.channel));
+        }
+
+        unsigned int search(unsigned int channel) const {
+            unsigned int i = 0;
+            for(; (i < _size) && (_heap[i].channel != channel); i++);
+            return i;
+        }
+
+        void up(unsigned int i) {
+            for(unsigned int p; i && before(_heap[i], _heap[p = (i - 1) / 2]); i = p)
+                swap(i, p);
+        }
+
+        void down(unsigned int i) {
+            for(unsigned int c; (c = 2 * i + 1) < _size; i = c) {
+                if((c + 1 < _size) && before(_heap[c + 1], _heap[c]))
+                    c++;
+                if(!before(_heap[c], _heap[i]))
+                    break;
+                swap(i, c);
+            }
+        }
+
+        void swap(unsigned int i, unsigned int j) {
+            Entry e = _heap[i];
+            _heap[i] = _heap[j];
+            _heap[j] = e;
+        }
+
+    private:
+        Tick _now;
+        Tick _next;
+        unsigned int _size;
+        volatile int _stale;
+        Entry _heap[CHANNELS];
+    };
+
 public:
     PC_Timer(const Hertz & frequency, const Handler & handler, const Channel & channel, bool retrigger = true):
         _channel(channel), _initial(FREQUENCY / frequency), _retrigger(retrigger), _handler(handler) {
         db<Timer>(TRC) << "Timer(f=" << frequency << ",h=" << reinterpret_cast<void*>(handler)
                        << ",ch=" << channel << ") => {count=" << _initial << "}" << endl;
 
-        if(_initial && (unsigned(channel) < CHANNELS) && !_channels[channel])
+        if(_initial && (unsigned(channel) < CHANNELS) && !_channels[channel]) {
             _channels[channel] = this;
-        else
+            stale();
+        } else
             db<Timer>(WRN) << "Timer not installed!"<< endl;
-
-        for(unsigned int i = 0; i < Traits<Machine>::CPUS; i++)
-            _current[i] = _initial;
     }
 
     ~PC_Timer() {
         db<Timer>(TRC) << "~Timer(f=" << frequency() << ",h=" << reinterpret_cast<void*>(_handler)
         	       << ",ch=" << _channel << ") => {count=" << _initial << "}" << endl;
 
-        _channels[_channel] = 0;
+        if(_channels[_channel] == this) {
+            _channels[_channel] = 0;
+            stale();
+        }
     }
 
     Hertz frequency() const { return (FREQUENCY / _initial); }
     void frequency(const Hertz & f) { _initial = FREQUENCY / f; reset(); }
 
-    Tick read() { return _current[Machine::cpu_id()]; }
+    // Ticks left in the current period on this CPU
+    Tick read() { return _mux[Machine::cpu_id()].remaining(_channel, _initial); }
 
     Tick reset_and_count() {
         return (reset() * _initial) / 100;
     }
 
     Tick tick_count() {
-		return _initial - _current[Machine::cpu_id()];
+		return _initial - read();
     }
 
+    // Restarts the current period on this CPU, returning the percentage of it that was left
     int reset() {
+        Multiplexer * mux = &_mux[Machine::cpu_id()];
+
+        bool ints = CPU::int_enabled();
+        CPU::int_disable();
+
+        Tick left = mux->remaining(_channel, _initial);
+        if(mux->remove(_channel))
+            mux->insert(_channel, _initial);
+
+        if(ints)
+            CPU::int_enable();
+
         db<Timer>(TRC) << "Timer::reset() => {f=" << frequency()
         	       << ",h=" << reinterpret_cast<void*>(_handler)
-        	       << ",count=" << _current[Machine::cpu_id()] << "}" << endl;
-
-        int percentage = _current[Machine::cpu_id()] * 100 / _initial;
-        _current[Machine::cpu_id()] = _initial;
+        	       << ",count=" << left << "}" << endl;
 
-        return percentage;
+        return left * 100 / _initial;
     }
 
     void handler(const Handler & handler) { _handler = handler; }
@@ -308,11 +435,26 @@ public:
     static void enable() { IC::enable(IC::INT_TIMER); }
     static void disable() { IC::disable(IC::INT_TIMER); }
 
+    // Asks for an interrupt on this CPU at time stamp "ts", upon which the
+    // deadline handler is called (high-resolution mode only)
+    static void deadline(const Time_Stamp & ts);
+    static void deadline_handler(const Handler & handler) { _deadline_handler = handler; }
+
  private:
     static Hertz count2freq(const Count & c) { return c ? Engine::clock() / c : 0; }
     static Count freq2count(const Hertz & f) { return f ? Engine::clock() / f : 0; }
 
+    static Time_Stamp tick() { return TSC::frequency() / FREQUENCY; }
+
     static void int_handler(const Interrupt_Id & i);
+    static void channels(const Interrupt_Id & i, unsigned int cpu);
+    static void rebuild(unsigned int cpu);
+
+    static void stale() {
+        for(unsigned int i = 0; i < Traits<Machine>::CPUS; i++)
+            _mux[i].invalidate();
+    }
+    static void program(unsigned int cpu);
 
     static void init();
 
@@ -320,10 +462,13 @@ protected:
     unsigned int _channel;
     Count _initial;
     bool _retrigger;
-    volatile Count _current[Traits<Machine>::CPUS];
     Handler _handler;
 
-    static PC_Timer * _channels[CHANNELS];
+    static PC_Timer * volatile _channels[CHANNELS];
+    static Multiplexer _mux[Traits<Machine>::CPUS];
+    static volatile Time_Stamp _next_tick[Traits<Machine>::CPUS];
+    static volatile Time_Stamp _deadline[Traits<Machine>::CPUS];
+    static Handler _deadline_handler;
 };
 
 
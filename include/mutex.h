@@ -17,6 +17,8 @@ public:
     void lock();
     void unlock();
 
+    using Synchronizer_Common::name;
+
 private:
     volatile bool _locked;
 };
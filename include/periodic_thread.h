@@ -0,0 +1,133 @@
+// EPOS Periodic Thread Abstraction Declarations
+
+// A Periodic_Thread is released by a periodic alarm through a semaphore, so
+// its jobs keep the period no matter how long each one takes. The body of
+// the thread is a loop around wait_next():
+//     while(Periodic_Thread::wait_next()) { ... job ... }
+// Each job is measured against its nominal release (the creation of the
+// thread plus a whole number of periods): release jitter is how late the job
+// started, response time is how late it finished, and an overrun is a job
+// that finished after the next release.
+
+#ifndef __periodic_thread_h
+#define __periodic_thread_h
+
+#include <thread.h>
+#include <semaphore.h>
+#include <alarm.h>
+#include <clock.h>
+
+__BEGIN_SYS
+
+class Periodic_Thread: public Thread
+{
+private:
+    typedef Clock::Time_Stamp Time_Stamp;
+
+public:
+    typedef RTC::Microsecond Microsecond;
+    typedef Clock::Nanosecond Nanosecond;
+
+    enum { INFINITE = Alarm::INFINITE };
+
+    // Periodic Thread Configuration
+    struct Configuration: public Thread::Configuration {
+        Configuration(const Microsecond & p, int n = INFINITE, const State & s = READY, const Criterion & c = NORMAL, unsigned int ss = STACK_SIZE)
+        : Thread::Configuration(s, c, ss), period(p), times(n) {}
+
+        Microsecond period;
+        int times;
+    };
+
+    // Job statistics, updated by the thread itself at each wait_next()
+    struct Statistics {
+        Statistics(): jobs(0), overruns(0), jitter_sum(0), jitter_max(0), response_sum(0), response_max(0) {}
+
+        Nanosecond jitter_average() const { return jobs ? jitter_sum / jobs : 0; }
+        Nanosecond response_average() const { return jobs ? response_sum / jobs : 0; }
+
+        unsigned int jobs;     // finished jobs
+        unsigned int overruns;
+        Nanosecond jitter_sum;
+        Nanosecond jitter_max;
+        Nanosecond response_sum;
+        Nanosecond response_max;
+    };
+
+public:
+    template<typename ... Tn>
+    Periodic_Thread(const Microsecond & p, int (* entry)(Tn ...), Tn ... an)
+    : Thread(Thread::Configuration(SUSPENDED), entry, an ...), _semaphore(0), _handler(&_semaphore), _times(INFINITE), _jobs(0),
+      _period(cycles(p)), _start(Clock::time_stamp()), _alarm(p, &_handler, INFINITE) {
+        resume();
+    }
+
+    template<typename ... Tn>
+    Periodic_Thread(const Configuration & conf, int (* entry)(Tn ...), Tn ... an)
+    : Thread(Thread::Configuration(SUSPENDED, conf.criterion, conf.stack_size), entry, an ...), _semaphore(0), _handler(&_semaphore), _times(conf.times), _jobs(0),
+      _period(cycles(conf.period)), _start(Clock::time_stamp()), _alarm(conf.period, &_handler, conf.times) {
+        if(conf.state == READY)
+            resume();
+    }
+
+    const Statistics & statistics() const { return _statistics; }
+
+    // Ends the current job (if any) and waits for the next release, returning false when there are no more jobs.
+    // Must be called by the periodic thread itself.
+    static bool wait_next() {
+        Periodic_Thread * t = static_cast<Periodic_Thread *>(running());
+
+        if(t->_statistics.jobs < t->_jobs)
+            t->finish(Clock::time_stamp());
+
+        if((t->_times != INFINITE) && (t->_jobs >= static_cast<unsigned int>(t->_times)))
+            return false;
+
+        t->_semaphore.p();
+
+        Time_Stamp now = Clock::time_stamp();
+        Time_Stamp release = t->release(t->_jobs);
+        t->_jobs++;
+
+        Nanosecond jitter = (now > release) ? Clock::nanoseconds(now - release) : 0;
+        t->_statistics.jitter_sum += jitter;
+        if(jitter > t->_statistics.jitter_max)
+            t->_statistics.jitter_max = jitter;
+
+        return true;
+    }
+
+private:
+    static Time_Stamp cycles(const Microsecond & time) {
+        return static_cast<Time_Stamp>(time) * TSC::frequency() / 1000000;
+    }
+
+    // Nominal release of the job-th job (from 0)
+    Time_Stamp release(unsigned int job) const { return _start + (job + 1) * _period; }
+
+    void finish(const Time_Stamp & now) {
+        Time_Stamp release = this->release(_jobs - 1);
+        Nanosecond response = (now > release) ? Clock::nanoseconds(now - release) : 0;
+
+        _statistics.jobs++;
+        _statistics.response_sum += response;
+        if(response > _statistics.response_max)
+            _statistics.response_max = response;
+        if(now > release + _period)
+            _statistics.overruns++;
+    }
+
+protected:
+    Semaphore _semaphore;
+    Semaphore_Handler _handler;
+    int _times;
+    unsigned int _jobs;  // released jobs taken so far
+    Time_Stamp _period;
+    Time_Stamp _start;
+    Statistics _statistics;
+    Alarm _alarm;        // last, so it starts when everything else is in place
+};
+
+__END_SYS
+
+#endif
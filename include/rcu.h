@@ -0,0 +1,130 @@
+// EPOS Read-Copy-Update Abstraction Declarations
+
+// RCU lets read-mostly data structures be traversed without locks, atomics or
+// disabling interrupts. Readers delimit their critical sections with
+// read_lock() and read_unlock(), which only touch a per-thread nesting counter
+// and defer preemption until the section ends. Writers publish a new version
+// of the data and hand the old one to call() or free(), which run after a
+// grace period, i.e., after every CPU has gone through Thread::dispatch()
+// outside a read-side critical section at least once (a quiescent state).
+// Readers must not block (sleep, yield, join, ...) inside a critical section.
+// Callbacks run outside Thread::lock(), either from the writer that registers
+// the next one, from synchronize() or from the idle threads.
+
+#ifndef __rcu_h
+#define __rcu_h
+
+#include <utility/list.h>
+#include <utility/handler.h>
+#include <utility/pool.h>
+#include <thread.h>
+
+__BEGIN_SYS
+
+class RCU
+{
+    friend class Thread;
+
+private:
+    static const bool enabled = Traits<RCU>::enabled;
+
+public:
+    // A callback to be invoked after a grace period; it must live until then
+    class Callback
+    {
+        friend class RCU;
+
+    public:
+        Callback(Handler * h): _handler(h), _link(this) {}
+
+    private:
+        Handler * _handler;
+        Simple_List<Callback>::Element _link;
+    };
+
+private:
+    typedef Simple_List<Callback> List;
+
+    // Deletes an object (and itself) after a grace period
+    template<typename T>
+    class Deleter: public Handler
+    {
+    public:
+        Deleter(T * o): _object(o), _callback(this) {}
+
+        void operator()() {
+            delete _object;
+            if(_deleters.contains(this)) {
+                this->~Deleter();
+                _deleters.free(this);
+            } else
+                delete this;
+        }
+
+        Callback * callback() { return &_callback; }
+
+    private:
+        T * _object;
+        Callback _callback;
+    };
+
+    // Deleters only differ in the type of the object pointer, so a single pool serves all of them.
+    // It is cached per CPU, since deleters are usually freed on a CPU other than the one that allocated them.
+    typedef Pool<Deleter<Callback>, Traits<RCU>::DELETERS, true> Deleters;
+
+public:
+    static void read_lock() {
+        if(enabled)
+            Thread::self()->_rcu_nesting++;
+    }
+
+    static void read_unlock() {
+        if(enabled) {
+            Thread * t = Thread::self();
+            if(!--t->_rcu_nesting && t->_rcu_deferred) {
+                t->_rcu_deferred = false;
+                Thread::yield(); // a preemption was requested during the critical section
+            }
+        }
+    }
+
+    // call_rcu: invokes c's handler after a grace period
+    static void call(Callback * c);
+
+    // Deletes o after a grace period
+    template<typename T>
+    static void free(T * o) {
+        Deleter<T> * d = new (_deleters) Deleter<T>(o);
+        if(!d)
+            d = new (SYSTEM) Deleter<T>(o);
+        call(d->callback());
+    }
+
+    // Blocks the calling thread until a full grace period has elapsed
+    static void synchronize();
+
+    // Invokes the callbacks whose grace periods have already elapsed
+    static void reclaim();
+
+private:
+    static bool running() { return _started != _completed; }
+
+    static void start();
+    static void quiescent(Thread * prev);
+
+    static void lock() { Thread::lock(); }
+    static void unlock() { Thread::unlock(); }
+
+private:
+    static volatile unsigned int _started;
+    static volatile unsigned int _completed;
+    static volatile unsigned int _pending; // CPUs yet to go through a quiescent state
+    static List _next;    // waiting for the next grace period to start
+    static List _current; // waiting for the current grace period to end
+    static List _done;    // ready to be invoked
+    static Deleters _deleters;
+};
+
+__END_SYS
+
+#endif
@@ -17,6 +17,8 @@ public:
     void p();
     void v();
 
+    using Synchronizer_Common::name;
+
 private:
     volatile int _value;
 };
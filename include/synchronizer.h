@@ -5,13 +5,17 @@
 
 #include <cpu.h>
 #include <thread.h>
+#include <utility/lock_profiler.h>
 
 __BEGIN_SYS
 
 class Synchronizer_Common
 {
 protected:
+    static const bool profiled = Traits<Synchronizer>::profiled;
+
     typedef Thread::Queue Queue;
+    typedef Lock_Profile<profiled> Profile;
 
 protected:
     Synchronizer_Common() {}
@@ -26,12 +30,34 @@ protected:
     void begin_atomic() { Thread::lock(); }
     void end_atomic() { Thread::unlock(); }
 
-    void sleep() { Thread::sleep(&_queue); }
+    // "acquiring" tells that the caller takes the synchronizer once woken up (see acquired())
+    void sleep(bool acquiring = false) {
+        if(profiled) {
+            unsigned int holder = _profile.holder();
+            Profile::Time_Stamp t0 = Profile::time_stamp();
+            Thread::sleep(&_queue);
+
+            // Several threads may be woken up at once (e.g. by a semaphore or a barrier), so accounting takes the lock
+            begin_atomic();
+            _profile.contended(holder, Profile::time_stamp() - t0);
+            if(acquiring)
+                acquired();
+            end_atomic();
+        } else
+            Thread::sleep(&_queue);
+    }
     void wakeup() { Thread::wakeup(&_queue); }
     void wakeup_all() { Thread::wakeup_all(&_queue); }
 
+    // Contention profiling (see utility/lock_profiler.h); must be called within begin_atomic()/end_atomic()
+    void acquired() { _profile.acquired(reinterpret_cast<unsigned int>(Thread::self())); }
+
+public:
+    void name(const char * n) { _profile.name(n); }
+
 protected:
     Queue _queue;
+    Profile _profile;
 };
 
 __END_SYS
@@ -19,9 +19,12 @@ class System
     friend void * ::operator new[](size_t, const EPOS::System_Allocator &);
     friend void ::operator delete(void *);
     friend void ::operator delete[](void *);
+    friend void * kmalloc(size_t);
+    friend void kfree(void *);
 
 public:
     static System_Info<Machine> * const info() { assert(_si); return _si; }
+    static Heap * heap() { return _heap; }
 
 private:
     static void init();
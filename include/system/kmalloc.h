@@ -12,7 +12,10 @@ inline void * kmalloc(size_t bytes) {
 }
 
 inline void kfree(void * ptr) {
-    System::_heap->free(ptr);
+    if(Traits<System>::multiheap)
+        Heap::typed_free(ptr);
+    else
+        Heap::untyped_free(System::_heap, ptr);
 }
 
 __END_SYS
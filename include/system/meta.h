@@ -25,6 +25,20 @@ struct IF_INT<false, Then, Else>
 { enum { Result = Else }; };
 
 
+// Integer base-2 logarithm (rounded down)
+template<unsigned int N>
+struct LOG2
+{ enum { Result = 1 + LOG2<(N >> 1)>::Result }; };
+
+template<>
+struct LOG2<1>
+{ enum { Result = 0 }; };
+
+template<>
+struct LOG2<0>
+{ enum { Result = 0 }; };
+
+
 // SWITCH-CASE of Types
 const int DEFAULT = ~(~0u >> 1); // Initialize with the smallest int
 
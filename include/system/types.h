@@ -101,6 +101,10 @@ class Synchronizer;
 class Mutex;
 class Semaphore;
 class Condition;
+class Barrier;
+class Latch;
+class Futex;
+class RCU;
 
 class Clock;
 class Chronometer;
@@ -137,6 +141,8 @@ enum
     MUTEX_ID,
     SEMAPHORE_ID,
     CONDITION_ID,
+    BARRIER_ID,
+    LATCH_ID,
 
     CLOCK_ID,
     ALARM_ID,
@@ -174,6 +180,8 @@ template<> struct Type<Segment> { static const Type_Id ID = SEGMENT_ID; };
 template<> struct Type<Mutex> { static const Type_Id ID = MUTEX_ID; };
 template<> struct Type<Semaphore> { static const Type_Id ID = SEMAPHORE_ID; };
 template<> struct Type<Condition> { static const Type_Id ID = CONDITION_ID; };
+template<> struct Type<Barrier> { static const Type_Id ID = BARRIER_ID; };
+template<> struct Type<Latch> { static const Type_Id ID = LATCH_ID; };
 
 template<> struct Type<Clock> { static const Type_Id ID = CLOCK_ID; };
 template<> struct Type<Chronometer> { static const Type_Id ID = CHRONOMETER_ID; };
@@ -23,8 +23,11 @@ class Thread
     friend class System;
     friend class Scheduler<Thread>;
     friend class Synchronizer_Common;
+    friend class Futex;
+    friend class RCU;
     friend class Alarm;
     friend class IA32;
+    friend class _UTIL::This_Thread;
 
 protected:
     static const bool smp = Traits<Thread>::smp;
@@ -162,6 +165,10 @@ protected:
     Queue * _waiting;
     Thread * volatile _joining;
     Queue::Element _link;
+    List::Element _suspend_link; // in toSuspend[] while a remote suspend() is pending
+    volatile unsigned int _rcu_nesting;
+    volatile bool _rcu_deferred;
+    bool _futex_waiting; // _waiting belongs to a Futex waiter (see Futex::abandon())
 
     static volatile unsigned int _thread_count;
     static Scheduler_Timer * _timer;
@@ -169,12 +176,14 @@ protected:
     static Scheduler<Thread> _scheduler;
     static Spin _lock;
     static List toSuspend [];
+
+    typedef Intrusive<Thread, List::Element, &Thread::_suspend_link> Suspending;
 };
 
 
 template<typename ... Tn>
 inline Thread::Thread(int (* entry)(Tn ...), Tn ... an)
-: _state(READY), _waiting(0), _joining(0), _link(this, NORMAL)
+: _state(READY), _waiting(0), _joining(0), _link(this, NORMAL), _suspend_link(this), _rcu_nesting(0), _rcu_deferred(false), _futex_waiting(false)
 {
     constructor_prolog(STACK_SIZE);
     _context = CPU::init_stack(_stack + STACK_SIZE, &__exit, entry, an ...);
@@ -183,7 +192,7 @@ inline Thread::Thread(int (* entry)(Tn ...), Tn ... an)
 
 template<typename ... Tn>
 inline Thread::Thread(const Configuration & conf, int (* entry)(Tn ...), Tn ... an)
-: _state(conf.state), _waiting(0), _joining(0), _link(this, conf.criterion)
+: _state(conf.state), _waiting(0), _joining(0), _link(this, conf.criterion), _suspend_link(this), _rcu_nesting(0), _rcu_deferred(false), _futex_waiting(false)
 {
     constructor_prolog(conf.stack_size);
     _context = CPU::init_stack(_stack + conf.stack_size, &__exit, entry, an ...);
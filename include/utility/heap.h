@@ -6,105 +6,659 @@
 #include <utility/debug.h>
 #include <utility/list.h>
 #include <utility/spin.h>
+#include <utility/tlsf.h>
+#include <utility/string.h>
 
 __BEGIN_UTIL
 
+// CPU id forwarder for the per-CPU caches (defined along with This_Thread::id())
+class This_CPU
+{
+public:
+    static unsigned int id();
+};
+
 // Heap
-class Heap: private Grouping_List<char>
+// Free memory is indexed by TLSF (see tlsf.h), which finds a good fit and
+// merges freed blocks with their neighbors in constant time.
+// Small blocks (header included) are served from segregated size classes of
+// power-of-two sizes, each a free list of equally sized blocks carved in slabs
+// from the TLSF index, which is only used for large blocks and for slab
+// refills. Memory handed to a size class is never merged back.
+// In front of the size classes, each CPU keeps a magazine (a short free list)
+// per class, which is used with interrupts disabled but without taking the
+// heap lock. Magazines are refilled from and drained to the size classes in
+// batches of half their capacity.
+// Besides plain allocations, heaps serve aligned blocks, resize blocks in
+// place when possible (see realloc()) and allocate blocks in batches.
+// A heap can be given a pair of functions to grow it with new memory regions
+// when it runs out and to give back grown regions once they are entirely free
+// (one free grown region is kept as a spare, so that the heap does not thrash).
+// When Traits<Heaps>::statistics is on, heaps also count the bytes in use (and
+// its peak) and the allocations and deallocations per size class, which stats()
+// reports along with the shape of the free memory.
+class Heap
 {
+public:
+    // Size classes
+    static const unsigned int CLASSES = Traits<Heaps>::SIZE_CLASSES;
+    static const unsigned int MIN_CLASS = 16;
+
 protected:
     static const bool typed = Traits<System>::multiheap;
 
+    static const unsigned int MAX_CLASS = MIN_CLASS << (CLASSES - 1);
+    static const unsigned int SLAB_SIZE = Traits<Heaps>::SLAB_SIZE;
+
+    static const unsigned int MAGAZINE_SIZE = Traits<Heaps>::MAGAZINE_SIZE;
+    static const bool cached = (MAGAZINE_SIZE > 1);
+    static const unsigned int CPUS = cached ? Traits<Build>::CPUS : 1;
+
+    static const bool statistics = Traits<Heaps>::statistics;
+    static const bool assert_unlocked = Traits<Heaps>::assert_unlocked;
+
+    static const unsigned int GROWTH = Traits<Heaps>::GROWTH;
+    static const unsigned int REGIONS = Traits<Heaps>::REGIONS;
+
+    // Block header: [heap pointer (typed heaps only)][size], right before the address handed out
+    static const unsigned int HEADER = (typed ? sizeof(void *) : 0) + sizeof(int);
+    static const unsigned int INDEXED = 1U << 31; // size flag: block taken from the TLSF index regardless of its size
+
+    // A free block in a size class
+    struct Block {
+        Block * next;
+    };
+
+    // A per-CPU cache of free blocks of a size class
+    struct Magazine {
+        Block * head;
+        unsigned int count;
+    };
+
+    // A region obtained through the grow function
+    struct Region {
+        char * addr;
+        unsigned int size;
+        void * cookie;
+    };
+
+public:
+    // Returns a new region of at least *bytes bytes (updating *bytes) or 0; "cookie" is handed back to Shrink
+    typedef void * (Grow)(unsigned int * bytes, void ** cookie);
+    typedef void (Shrink)(void * addr, unsigned int bytes, void * cookie);
+
+public:
+    // Heap usage and fragmentation snapshot (in bytes, headers included)
+    struct Statistics {
+        unsigned int in_use;
+        unsigned int peak;
+        unsigned int free;
+        unsigned int largest;       // largest free block
+        unsigned int blocks;        // number of free blocks
+        unsigned int fragmentation; // 0 (a single free block) to 100 (free memory fully splintered)
+        unsigned int allocs[CLASSES + 1]; // per size class, large blocks last
+        unsigned int frees[CLASSES + 1];
+
+        friend OStream & operator<<(OStream & os, const Statistics & s) {
+            os << "{use=" << s.in_use << ",peak=" << s.peak << ",free=" << s.free
+               << ",largest=" << s.largest << ",blocks=" << s.blocks << ",frag=" << s.fragmentation << "%,ops={";
+            for(unsigned int i = 0; i <= CLASSES; i++) {
+                if(i < CLASSES)
+                    os << (MIN_CLASS << i);
+                else
+                    os << "large";
+                os << ":" << s.allocs[i] << "/" << s.frees[i] << ((i < CLASSES) ? "," : "");
+            }
+            os << "}}";
+            return os;
+        }
+    };
+
 public:
-    using Grouping_List<char>::empty;
-    using Grouping_List<char>::size;
 
     Heap() {
         db<Init, Heaps>(TRC) << "Heap() => " << this << endl;
+
+        init();
     }
 
     Heap(void * addr, unsigned int bytes) {
         db<Init, Heaps>(TRC) << "Heap(addr=" << addr << ",bytes=" << bytes << ") => " << this << endl;
 
+        init();
         free(addr, bytes);
     }
 
     void * alloc(unsigned int bytes) {
-    	acquire();
+        if(!bytes)
+            return 0;
+
         db<Heaps>(TRC) << "Heap::alloc(this=" << this << ",bytes=" << bytes;
 
-        if(!bytes)
+        if(assert_unlocked && This_Thread::locked())
+            locked();
+
+        bytes = block_size(bytes);
+
+        int * addr;
+        unsigned int c = size_class(bytes);
+        if(c < CLASSES) {
+            bytes = MIN_CLASS << c;
+            addr = reinterpret_cast<int *>(get(c));
+        } else {
+            bool ints = acquire();
+            addr = reinterpret_cast<int *>(_index.alloc(bytes));
+            release(ints);
+        }
+
+        if(!addr && _grow && grow(bytes)) {
+            if(c < CLASSES)
+                addr = reinterpret_cast<int *>(get(c));
+            else {
+                bool ints = acquire();
+                addr = reinterpret_cast<int *>(_index.alloc(bytes));
+                release(ints);
+            }
+        }
+
+        if(!addr) {
+            out_of_memory();
             return 0;
+        }
 
-        if(!Traits<CPU>::unaligned_memory_access)
-            while((bytes % sizeof(void *)))
-                ++bytes;
+        if(statistics)
+            account(c, bytes, true);
 
-        if(typed)
-            bytes += sizeof(void *);  // add room for heap pointer
-        bytes += sizeof(int);         // add room for size
-        if(bytes < sizeof(Element))
-            bytes = sizeof(Element);
+        addr = header(addr, (c < CLASSES) ? bytes : bytes | INDEXED);
+
+        db<Heaps>(TRC) << ") => " << reinterpret_cast<void *>(addr) << endl;
+
+        return addr;
+    }
+
+    // Returns a block whose address is a multiple of "align" (a power of two).
+    // Aligned blocks always come from the TLSF index, which splits the
+    // misalignment off and keeps it, instead of wasting it as padding.
+    void * alloc(unsigned int bytes, unsigned int align) {
+        if(align <= sizeof(int))
+            return alloc(bytes);
 
-        Element * e = search_decrementing(bytes);
-        if(!e) {
+        if(!bytes || (align & (align - 1)))
+            return 0;
+
+        db<Heaps>(TRC) << "Heap::alloc(this=" << this << ",bytes=" << bytes << ",align=" << align;
+
+        if(assert_unlocked && This_Thread::locked())
+            locked();
+
+        bytes = block_size(bytes);
+
+        bool ints = acquire();
+        int * addr = reinterpret_cast<int *>(_index.alloc(bytes, align, HEADER));
+        release(ints);
+
+        if(!addr && _grow && grow(bytes + align + TLSF::OVERHEAD + TLSF::MIN_SIZE)) {
+            ints = acquire();
+            addr = reinterpret_cast<int *>(_index.alloc(bytes, align, HEADER));
+            release(ints);
+        }
+
+        if(!addr) {
             out_of_memory();
             return 0;
         }
 
-        int * addr = reinterpret_cast<int *>(e->object() + e->size());
+        if(statistics)
+            account(CLASSES, bytes, true);
 
-        if(typed)
-            *addr++ = reinterpret_cast<int>(this);
-        *addr++ = bytes;
+        addr = header(addr, bytes | INDEXED);
 
         db<Heaps>(TRC) << ") => " << reinterpret_cast<void *>(addr) << endl;
 
-        release();
         return addr;
     }
 
+    // Allocates n blocks of "bytes" bytes into ptrs at once, taking the heap
+    // lock at most once per pass, and returns how many could be allocated
+    unsigned int alloc(unsigned int n, unsigned int bytes, void ** ptrs) {
+        if(!bytes)
+            return 0;
+
+        db<Heaps>(TRC) << "Heap::alloc(this=" << this << ",n=" << n << ",bytes=" << bytes << ")" << endl;
+
+        if(assert_unlocked && This_Thread::locked())
+            locked();
+
+        bytes = block_size(bytes);
+
+        unsigned int c = size_class(bytes);
+        if(c < CLASSES)
+            bytes = MIN_CLASS << c;
+
+        unsigned int i = get(c, bytes, ptrs, n);
+        if((i < n) && _grow && grow((n - i) * bytes))
+            i += get(c, bytes, ptrs + i, n - i);
+
+        for(unsigned int j = 0; j < i; j++) {
+            if(statistics)
+                account(c, bytes, true);
+            ptrs[j] = header(reinterpret_cast<int *>(ptrs[j]), (c < CLASSES) ? bytes : bytes | INDEXED);
+        }
+
+        return i;
+    }
+
+    // Resizes a block returned by alloc(). Blocks from the TLSF index grow into
+    // the free block right after them and shrink in place; blocks from a size
+    // class stay put while the new size fits the class. Only otherwise is the
+    // content copied to a new block.
+    void * realloc(void * ptr, unsigned int bytes) {
+        if(!ptr)
+            return alloc(bytes);
+
+        db<Heaps>(TRC) << "Heap::realloc(this=" << this << ",ptr=" << ptr << ",bytes=" << bytes << ")" << endl;
+
+        int * addr = reinterpret_cast<int *>(ptr);
+        unsigned int old = addr[-1];
+        void * block = reinterpret_cast<char *>(ptr) - HEADER;
+
+        if(!bytes) {
+            dealloc(block, old);
+            return 0;
+        }
+
+        unsigned int size = block_size(bytes);
+        if(old & INDEXED) {
+            bool ints = acquire();
+            bool resized = _index.resize(block, size);
+            release(ints);
+            if(resized) {
+                if(statistics) {
+                    account(CLASSES, old & ~INDEXED, false);
+                    account(CLASSES, size, true);
+                }
+                addr[-1] = size | INDEXED;
+                return ptr;
+            }
+        } else if(size <= old)
+            return ptr;
+
+        void * p = alloc(bytes);
+        if(p) {
+            unsigned int n = (old & ~INDEXED) - HEADER;
+            memcpy(p, ptr, (bytes < n) ? bytes : n);
+            dealloc(block, old);
+        }
+
+        return p;
+    }
+
+    // Adds the memory region [ptr, ptr + bytes) to the heap
     void free(void * ptr, unsigned int bytes) {
-    	acquire();
         db<Heaps>(TRC) << "Heap::free(this=" << this << ",ptr=" << ptr << ",bytes=" << bytes << ")" << endl;
 
-        if(ptr && (bytes >= sizeof(Element))) {
-            Element * e = new (ptr) Element(reinterpret_cast<char *>(ptr), bytes);
-            Element * m1, * m2;
-            insert_merging(e, &m1, &m2);
+        if(!ptr)
+            return;
+
+        unsigned int c = size_class(bytes);
+        if((c < CLASSES) && (bytes == (MIN_CLASS << c)))
+            put(c, ptr);
+        else {
+            bool ints = acquire();
+            _index.insert(ptr, bytes);
+            release(ints);
         }
-        release();
     }
 
+    void grower(Grow * grow, Shrink * shrink) {
+        _grow = grow;
+        _shrink = shrink;
+    }
+
+    bool empty() { return _index.empty(); }
+    unsigned int size() { return _index.blocks(); }
+
+    // The size stored in the header tells whether the block belongs to a size class
     static void typed_free(void * ptr) {
         int * addr = reinterpret_cast<int *>(ptr);
         unsigned int bytes = *--addr;
         Heap * heap = reinterpret_cast<Heap *>(*--addr);
-        heap->free(addr, bytes);
+        heap->dealloc(addr, bytes);
     }
 
     static void untyped_free(Heap * heap, void * ptr) {
         int * addr = reinterpret_cast<int *>(ptr);
         unsigned int bytes = *--addr;
-        heap->free(addr, bytes);
+        heap->dealloc(addr, bytes);
+    }
+
+    static void typed_free(unsigned int n, void ** ptrs) {
+        for(unsigned int i = 0; i < n; i++)
+            if(ptrs[i])
+                typed_free(ptrs[i]);
+    }
+
+    static void untyped_free(Heap * heap, unsigned int n, void ** ptrs) {
+        for(unsigned int i = 0; i < n; i++)
+            if(ptrs[i])
+                untyped_free(heap, ptrs[i]);
     }
 
+    static void * typed_realloc(void * ptr, unsigned int bytes) {
+        Heap * heap = reinterpret_cast<Heap *>(reinterpret_cast<int *>(ptr)[-2]);
+        return heap->realloc(ptr, bytes);
+    }
+
+    Statistics stats();
+    void dump(OStream & os);
+
 private:
+    void init() {
+        spin.name("Heap::spin");
+        for(unsigned int i = 0; i < CLASSES; i++)
+            _class[i] = 0;
+        for(unsigned int i = 0; i < CPUS; i++)
+            for(unsigned int j = 0; j < CLASSES; j++) {
+                _magazine[i][j].head = 0;
+                _magazine[i][j].count = 0;
+            }
+        _grow = 0;
+        _shrink = 0;
+        for(unsigned int i = 0; i < REGIONS; i++)
+            _region[i].addr = 0;
+        _in_use = _peak = 0;
+        for(unsigned int i = 0; i <= CLASSES; i++)
+            _allocs[i] = _frees[i] = 0;
+    }
+
+    // Counters are shared by all CPUs, since magazines are used without the heap lock
+    void account(unsigned int c, unsigned int bytes, bool alloc) {
+        unsigned int use, peak;
+        if(alloc) {
+            CPU::finc(_allocs[c]);
+            do
+                use = _in_use;
+            while(CPU::cas(_in_use, use, use + bytes) != use);
+            use += bytes;
+            do
+                peak = _peak;
+            while((use > peak) && (CPU::cas(_peak, peak, use) != peak));
+        } else {
+            CPU::finc(_frees[c]);
+            do
+                use = _in_use;
+            while(CPU::cas(_in_use, use, use - bytes) != use);
+        }
+    }
+
     void out_of_memory();
-    Spin spin;
-    bool _heap_int_enabled;
+    void locked();
+
+    // Gives back a block returned by alloc() (starting at its header)
+    void dealloc(void * ptr, unsigned int bytes) {
+        db<Heaps>(TRC) << "Heap::dealloc(this=" << this << ",ptr=" << ptr << ",bytes=" << bytes << ")" << endl;
+
+        if(assert_unlocked && This_Thread::locked())
+            locked();
+
+        unsigned int c = (bytes & INDEXED) ? CLASSES : size_class(bytes);
+        bytes &= ~INDEXED;
+
+        if(statistics)
+            account(c, bytes, false);
 
-    void acquire(){
-    	_heap_int_enabled = CPU::int_enabled();
-    	CPU::int_disable();
-    	spin.acquire();
+        if(c < CLASSES)
+            put(c, ptr);
+        else {
+            bool ints = acquire();
+            _index.free(ptr);
+            Region r;
+            bool shrink = _shrink && take(ptr, &r);
+            release(ints);
+            if(shrink) {
+                db<Heaps>(INF) << "Heap::shrink(this=" << this << ",addr=" << reinterpret_cast<void *>(r.addr) << ",bytes=" << r.size << ")" << endl;
+                _shrink(r.addr, r.size, r.cookie);
+            }
+        }
     }
 
-    void release(){
-    	spin.release();
-    	if(_heap_int_enabled)
-    		CPU::int_enable();
+    // Grows the heap by a region large enough for a "bytes"-byte block (or a slab)
+    bool grow(unsigned int bytes) {
+        unsigned int n = bytes + SLAB_SIZE + 4 * TLSF::OVERHEAD;
+        if(n < GROWTH)
+            n = GROWTH;
+
+        void * cookie;
+        char * addr = reinterpret_cast<char *>(_grow(&n, &cookie));
+        if(!addr)
+            return false;
+
+        db<Heaps>(INF) << "Heap::grow(this=" << this << ",addr=" << reinterpret_cast<void *>(addr) << ",bytes=" << n << ")" << endl;
+
+        bool ints = acquire();
+        for(unsigned int i = 0; i < REGIONS; i++)
+            if(!_region[i].addr) {
+                _region[i].addr = addr;
+                _region[i].size = n;
+                _region[i].cookie = cookie;
+                break;
+            }
+        _index.insert(addr, n); // untracked regions (no free slot) are simply never given back
+        release(ints);
+
+        return true;
     }
+
+    // Takes the grown region containing ptr out of the heap if it became entirely free (requires the heap lock).
+    // One free grown region is always kept, so a workload that frees and allocates around a region boundary
+    // does not shrink and grow the heap at every call.
+    bool take(void * ptr, Region * r) {
+        unsigned int i = 0;
+        for(; (i < REGIONS) && !(_region[i].addr && (ptr >= _region[i].addr) && (ptr < _region[i].addr + _region[i].size)); i++);
+        if((i == REGIONS) || !_index.unused(_region[i].addr, _region[i].size))
+            return false;
+
+        unsigned int j = 0;
+        for(; (j < REGIONS) && !((j != i) && _region[j].addr && _index.unused(_region[j].addr, _region[j].size)); j++);
+        if(j == REGIONS)
+            return false; // this is the spare
+
+        _index.release(_region[i].addr, _region[i].size);
+        *r = _region[i];
+        _region[i].addr = 0;
+        return true;
+    }
+
+    // Size of the block needed for a "bytes"-byte request, header included
+    static unsigned int block_size(unsigned int bytes) {
+        if(!Traits<CPU>::unaligned_memory_access)
+            bytes = (bytes + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+        return bytes + HEADER;
+    }
+
+    int * header(int * addr, unsigned int bytes) {
+        if(typed)
+            *addr++ = reinterpret_cast<int>(this);
+        *addr++ = bytes;
+        return addr;
+    }
+
+    // Takes up to n blocks of "bytes" bytes (of class c) at once into ptrs
+    unsigned int get(unsigned int c, unsigned int bytes, void ** ptrs, unsigned int n) {
+        unsigned int i = 0;
+
+        if(c < CLASSES) {
+            bool ints = CPU::int_enabled();
+            CPU::int_disable();
+
+            if(cached) {
+                Magazine * m = &_magazine[This_CPU::id()][c];
+                for(; (i < n) && m->head; i++) {
+                    Block * b = m->head;
+                    m->head = b->next;
+                    m->count--;
+                    ptrs[i] = b;
+                }
+            }
+
+            // Whatever the magazine could not serve comes straight from the class
+            if(i < n) {
+                spin.acquire();
+                for(; (i < n) && (ptrs[i] = pop(c)); i++);
+                spin.release();
+            }
+
+            if(ints)
+                CPU::int_enable();
+        } else {
+            bool ints = acquire();
+            for(; (i < n) && (ptrs[i] = _index.alloc(bytes)); i++);
+            release(ints);
+        }
+
+        return i;
+    }
+
+    static unsigned int size_class(unsigned int bytes) {
+        unsigned int c = 0;
+        for(; (c < CLASSES) && (bytes > (MIN_CLASS << c)); c++);
+        return c;
+    }
+
+    void * get(unsigned int c) {
+        if(!cached) {
+            bool ints = acquire();
+            void * b = pop(c);
+            release(ints);
+            return b;
+        }
+
+        // Disabling interrupts pins the thread to this CPU's magazine
+        bool ints = CPU::int_enabled();
+        CPU::int_disable();
+
+        Magazine * m = &_magazine[This_CPU::id()][c];
+        if(!m->head) {
+            spin.acquire();
+            for(unsigned int i = 0; i < MAGAZINE_SIZE / 2; i++) {
+                Block * b = reinterpret_cast<Block *>(pop(c));
+                if(!b)
+                    break;
+                b->next = m->head;
+                m->head = b;
+                m->count++;
+            }
+            spin.release();
+        }
+
+        Block * b = m->head;
+        if(b) {
+            m->head = b->next;
+            m->count--;
+        }
+
+        if(ints)
+            CPU::int_enable();
+
+        return b;
+    }
+
+    void put(unsigned int c, void * ptr) {
+        if(!cached) {
+            bool ints = acquire();
+            push(c, ptr);
+            release(ints);
+            return;
+        }
+
+        bool ints = CPU::int_enabled();
+        CPU::int_disable();
+
+        Magazine * m = &_magazine[This_CPU::id()][c];
+        Block * b = reinterpret_cast<Block *>(ptr);
+        b->next = m->head;
+        m->head = b;
+        m->count++;
+
+        if(m->count > MAGAZINE_SIZE) {
+            spin.acquire();
+            for(unsigned int i = 0; i < MAGAZINE_SIZE / 2; i++) {
+                b = m->head;
+                m->head = b->next;
+                m->count--;
+                push(c, b);
+            }
+            spin.release();
+        }
+
+        if(ints)
+            CPU::int_enable();
+    }
+
+    // push(), pop() and refill() operate on the shared size classes and require the heap lock
+    void push(unsigned int c, void * ptr) {
+        Block * b = reinterpret_cast<Block *>(ptr);
+        b->next = _class[c];
+        _class[c] = b;
+    }
+
+    void * pop(unsigned int c) {
+        if(!_class[c])
+            refill(c);
+
+        Block * b = _class[c];
+        if(b)
+            _class[c] = b->next;
+
+        return b;
+    }
+
+    // Carves a slab (or at least a single block) from the TLSF index into class c
+    void refill(unsigned int c) {
+        unsigned int bytes = MIN_CLASS << c;
+        unsigned int n = (SLAB_SIZE > bytes) ? SLAB_SIZE / bytes : 1;
+
+        char * slab = reinterpret_cast<char *>(_index.alloc(n * bytes));
+        if(!slab && (n > 1)) {
+            n = 1;
+            slab = reinterpret_cast<char *>(_index.alloc(bytes));
+        }
+        if(!slab)
+            return;
+
+        db<Heaps>(INF) << "Heap::refill(this=" << this << ",class=" << bytes << ",n=" << n << ")" << endl;
+
+        for(unsigned int i = 0; i < n; i++)
+            push(c, slab + i * bytes);
+    }
+
+    // The interrupt state is returned to the caller instead of being stored in the heap,
+    // since concurrent callers on different CPUs would overwrite each other's
+    bool acquire() {
+        bool ints = CPU::int_enabled();
+        CPU::int_disable();
+        spin.acquire();
+        return ints;
+    }
+
+    void release(bool ints) {
+        spin.release();
+        if(ints)
+            CPU::int_enable();
+    }
+
+private:
+    Spin spin;
+    TLSF _index;
+    Grow * _grow;
+    Shrink * _shrink;
+    Region _region[REGIONS];
+    Block * _class[CLASSES];
+    Magazine _magazine[CPUS][CLASSES];
+    volatile unsigned int _in_use;
+    volatile unsigned int _peak;
+    volatile unsigned int _allocs[CLASSES + 1];
+    volatile unsigned int _frees[CLASSES + 1];
 };
 
 __END_UTIL
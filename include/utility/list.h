@@ -264,6 +264,30 @@ namespace List_Elements
 };
 
 
+// Intrusive Links
+// Objects embed the elements that link them into lists (e.g. Thread::_link),
+// so inserting and removing them never touches the heap, which is mandatory
+// for paths that run with Thread::locked() (see Traits<Heaps>::assert_unlocked).
+// Intrusive maps an object to its embedded element and back, the latter by
+// subtracting the element's offset within the object.
+template<typename T, typename E, E T::* link>
+class Intrusive
+{
+public:
+    typedef T Object_Type;
+    typedef E Element;
+
+public:
+    static Element * element(T * o) { return &(o->*link); }
+    static T * object(Element * e) { return reinterpret_cast<T *>(reinterpret_cast<char *>(e) - offset()); }
+
+    static unsigned int offset() {
+        T * o = reinterpret_cast<T *>(sizeof(T)); // any non-null address will do, since only the difference is used
+        return reinterpret_cast<char *>(&(o->*link)) - reinterpret_cast<char *>(o);
+    }
+};
+
+
 // List Iterators
 namespace List_Iterators
 {
@@ -0,0 +1,191 @@
+// EPOS Lock Contention Profiler Utility Declarations
+
+// Lock_Profile<true> records, for a single lock instance, how many times it
+// was acquired, how many of those acquisitions had to wait, the total and
+// maximum waiting time (in TSC cycles) and the holder that caused the longest
+// wait. Lock_Profile<false> is empty and all its methods vanish at compile
+// time, so locks pay nothing when profiling is disabled (see Traits<Spin> and
+// Traits<Synchronizer>).
+// Enabled profiles register themselves at the Lock_Profiler, which can dump
+// the N most contended locks in the system.
+
+#ifndef __lock_profiler_h
+#define __lock_profiler_h
+
+#include <cpu.h>
+#include <tsc.h>
+
+__BEGIN_UTIL
+
+class Lock_Profiler;
+
+template<bool enabled>
+class Lock_Profile
+{
+public:
+    typedef TSC::Time_Stamp Time_Stamp;
+
+public:
+    Lock_Profile() {}
+
+    void name(const char * n) {}
+    unsigned int holder() const { return 0; }
+
+    void acquired(unsigned int who) {}
+    void contended(unsigned int holder, const Time_Stamp & wait) {}
+
+    static Time_Stamp time_stamp() { return 0; }
+};
+
+template<>
+class Lock_Profile<true>
+{
+    friend class Lock_Profiler;
+
+public:
+    typedef TSC::Time_Stamp Time_Stamp;
+
+public:
+    Lock_Profile(): _name(0), _acquisitions(0), _contentions(0), _total_wait(0), _max_wait(0), _holder(0), _top_holder(0) { attach(); }
+    ~Lock_Profile() { detach(); }
+
+    void name(const char * n) { _name = n; }
+    unsigned int holder() const { return _holder; }
+
+    // Counters are updated while the lock is held, so no extra atomics are needed
+    void acquired(unsigned int who) {
+        _acquisitions++;
+        _holder = who;
+    }
+
+    void contended(unsigned int holder, const Time_Stamp & wait) {
+        _contentions++;
+        _total_wait += wait;
+        if(wait > _max_wait) {
+            _max_wait = wait;
+            _top_holder = holder;
+        }
+    }
+
+    static Time_Stamp time_stamp() { return TSC::time_stamp(); }
+
+    friend OStream & operator<<(OStream & os, const Lock_Profile & p) {
+        os << "{lock=" << (p._name ? p._name : "?") << "@" << reinterpret_cast<const void *>(&p)
+           << ",acq=" << p._acquisitions
+           << ",cont=" << p._contentions
+           << ",wait={tot=" << p._total_wait
+           << ",avg=" << (p._contentions ? p._total_wait / p._contentions : 0)
+           << ",max=" << p._max_wait
+           << "},top=" << reinterpret_cast<void *>(p._top_holder) << "}";
+        return os;
+    }
+
+private:
+    inline void attach();
+    inline void detach();
+
+private:
+    const char * _name;
+    volatile unsigned int _acquisitions;
+    volatile unsigned int _contentions;
+    Time_Stamp _total_wait;
+    Time_Stamp _max_wait;
+    volatile unsigned int _holder;
+    unsigned int _top_holder;
+    bool _reported;
+    Lock_Profile * _next;
+};
+
+
+// Registry of enabled lock profiles
+// The registry is a plain, zero-initialized singly-linked list so that locks
+// constructed before it (static objects in other translation units) can still
+// register. Since global objects may be constructed more than once on SMP
+// configurations, registering an already known profile is a no-op.
+class Lock_Profiler
+{
+    friend class Lock_Profile<true>;
+
+private:
+    typedef Lock_Profile<true> Profile;
+
+public:
+    static unsigned int size() {
+        unsigned int n = 0;
+        for(Profile * p = _head; p; p = p->_next)
+            n++;
+        return n;
+    }
+
+    // Prints the "n" locks with the highest contention counts
+    static void dump(OStream & os, unsigned int n = 10) {
+        lock();
+
+        for(Profile * p = _head; p; p = p->_next)
+            p->_reported = false;
+
+        os << "Lock_Profiler::dump(n=" << n << ")" << endl;
+        for(unsigned int i = 0; i < n; i++) {
+            Profile * max = 0;
+            for(Profile * p = _head; p; p = p->_next)
+                if(!p->_reported && (!max || (p->_contentions > max->_contentions)))
+                    max = p;
+            if(!max)
+                break;
+            max->_reported = true;
+            os << "[" << i << "] " << *max << endl;
+        }
+
+        unlock();
+    }
+
+    static void reset() {
+        lock();
+        for(Profile * p = _head; p; p = p->_next) {
+            p->_acquisitions = p->_contentions = 0;
+            p->_total_wait = p->_max_wait = 0;
+            p->_top_holder = 0;
+        }
+        unlock();
+    }
+
+private:
+    // The registry cannot use Spin, which is itself profiled
+    static void lock() { while(CPU::tsl(_lock)); }
+    static void unlock() { _lock = false; }
+
+    static void insert(Profile * p) {
+        lock();
+        Profile * q = _head;
+        for(; q && (q != p); q = q->_next);
+        if(!q) {
+            p->_next = _head;
+            _head = p;
+        }
+        unlock();
+    }
+
+    static void remove(Profile * p) {
+        lock();
+        if(_head == p)
+            _head = p->_next;
+        else
+            for(Profile * q = _head; q; q = q->_next)
+                if(q->_next == p) {
+                    q->_next = p->_next;
+                    break;
+                }
+        unlock();
+    }
+
+private:
+    static Profile * _head;
+    static volatile bool _lock;
+};
+
+inline void Lock_Profile<true>::attach() { Lock_Profiler::insert(this); }
+inline void Lock_Profile<true>::detach() { Lock_Profiler::remove(this); }
+
+__END_UTIL
+
+#endif
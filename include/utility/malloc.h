@@ -31,6 +31,49 @@ extern "C"
         else
             Heap::untyped_free(System::_heap, ptr);
     }
+
+    inline void * realloc(void * ptr, size_t bytes) {
+        __USING_SYS;
+        if(!ptr)
+            return malloc(bytes);
+        if(Traits<System>::multiheap)
+            return Heap::typed_realloc(ptr, bytes);
+        else
+            return System::heap()->realloc(ptr, bytes);
+    }
+
+    inline void * memalign(size_t align, size_t bytes) {
+        __USING_SYS;
+        if(Traits<System>::multiheap)
+            return Application::heap()->alloc(bytes, align);
+        else
+            return System::heap()->alloc(bytes, align);
+    }
+
+    // Returns 0, EINVAL (22) for an alignment that is not a power of two multiple of sizeof(void *), or ENOMEM (12)
+    inline int posix_memalign(void ** ptr, size_t align, size_t bytes) {
+        if(!align || (align % sizeof(void *)) || (align & (align - 1)))
+            return 22;
+        *ptr = memalign(align, bytes);
+        return (*ptr || !bytes) ? 0 : 12;
+    }
+
+    // EPOS extensions: allocate or free n blocks at once; malloc_batch() returns how many were allocated
+    inline size_t malloc_batch(size_t n, size_t bytes, void ** ptrs) {
+        __USING_SYS;
+        if(Traits<System>::multiheap)
+            return Application::heap()->alloc(n, bytes, ptrs);
+        else
+            return System::heap()->alloc(n, bytes, ptrs);
+    }
+
+    inline void free_batch(size_t n, void ** ptrs) {
+        __USING_SYS;
+        if(Traits<System>::multiheap)
+            Heap::typed_free(n, ptrs);
+        else
+            Heap::untyped_free(System::heap(), n, ptrs);
+    }
 }
 
 // C++ dynamic memory allocators and deallocators
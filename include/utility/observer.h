@@ -6,14 +6,35 @@
 // Since the purpose of the destructors is only to trace the classes, we accepted to
 // declare them as non-virtual. But it must be clear that this is one of the few uses
 // for them.
+// Observers are notified as RCU readers, so notify() takes no locks and detach()
+// waits for a grace period before returning, after which the observer may go away.
+// Thus detach() must be called by a thread. Writers (attach() and detach()) must
+// still be serialized by their callers.
 
 #ifndef __observer_h
 #define	__observer_h
 
 #include <utility/list.h>
+#include <utility/spin.h>
 
 __BEGIN_UTIL
 
+// Forwarder to RCU (defined along with it), which is only used after the system has booted
+class Observation
+{
+public:
+    static void read_lock() { if(rcu && !This_Thread::booting()) rcu_read_lock(); }
+    static void read_unlock() { if(rcu && !This_Thread::booting()) rcu_read_unlock(); }
+    static void synchronize() { if(rcu && !This_Thread::booting()) rcu_synchronize(); }
+
+private:
+    static const bool rcu = Traits<RCU>::enabled;
+
+    static void rcu_read_lock();
+    static void rcu_read_unlock();
+    static void rcu_synchronize();
+};
+
 // Observer x Observed
 class Observer;
 
@@ -74,6 +95,7 @@ inline void Observed::detach(Observer * o)
     db<Observed>(TRC) << "Observed::detach(obs=" << o << ")" << endl;
 
     _observers.remove(&o->_link);
+    Observation::synchronize();
 }
 
 inline bool Observed::notify()
@@ -82,12 +104,14 @@ inline bool Observed::notify()
 
     db<Observed>(TRC) << "Observed::notify()" << endl;
 
+    Observation::read_lock();
     for(Element * e = _observers.head(); e; e = e->next()) {
         db<Observed>(INF) << "Observed::notify(this=" << this << ",obs=" << e->object() << ")" << endl;
 
         e->object()->update(this);
         notified = true;
     }
+    Observation::read_unlock();
 
     return notified;
 }
@@ -164,6 +188,7 @@ inline void Conditionally_Observed<T>::detach(Conditional_Observer<T> * o, T c)
     db<Observed>(TRC) << "Observed::detach(obs=" << o << ",c=" << c << ")" << endl;
 
     _observers.remove(&o->_link);
+    Observation::synchronize();
 }
 
 template<typename T>
@@ -173,6 +198,7 @@ inline bool Conditionally_Observed<T>::notify(T c)
 
     db<Observed>(TRC) << "Observed::notify(cond=" << hex << c << ")" << endl;
 
+    Observation::read_lock();
     for(Element * e = _observers.head(); e; e = e->next()) {
         if(e->rank() == c) {
             db<Observed>(INF) << "Observed::notify(this=" << this << ",obs=" << e->object() << ")" << endl;
@@ -180,6 +206,7 @@ inline bool Conditionally_Observed<T>::notify(T c)
             notified = true;
         }
     }
+    Observation::read_unlock();
 
     return notified;
 }
@@ -221,6 +248,7 @@ public:
         db<Observed>(TRC) << "Observed::detach(obs=" << o << ",cond=" << c << ")" << endl;
 
         _observers.remove(&o->_link);
+        Observation::synchronize();
     }
 
     virtual bool notify(T2 c, T1 * d) {
@@ -228,6 +256,7 @@ public:
 
         db<Observed>(TRC) << "Observed::notify(this=" << this << ",cond=" << c << ")" << endl;
 
+        Observation::read_lock();
         for(Element * e = _observers.head(); e; e = e->next()) {
             if(e->rank() == c) {
                 db<Observed>(INF) << "Observed::notify(this=" << this << ",obs=" << e->object() << ")" << endl;
@@ -235,6 +264,7 @@ public:
                 notified = true;
             }
         }
+        Observation::read_unlock();
 
         return notified;
     }
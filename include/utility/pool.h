@@ -0,0 +1,246 @@
+// EPOS Object Pool and Arena Utility Declarations
+
+// Pool<T, N> keeps N slots for objects of type T in its own storage, so
+// objects that are created and destroyed at high rates do not fragment the
+// heap. Free slots are chained through an intrusive list, thus alloc() and
+// free() are O(1). Pools whose "cached" parameter is true keep a short list
+// of free slots per CPU in front of the shared one. Each of these caches has
+// a lock of its own, which is only contended when a CPU that found both its
+// cache and the shared list empty takes a slot from another CPU's cache, so
+// alloc() only fails when there is no free slot left at all.
+// Arena is a bump-pointer allocator over a given memory region. Objects are
+// never freed individually: the whole arena is reset at once, which suits
+// allocations scoped to a phase (e.g. initialization or a single request).
+// Both are used through placement new: "new (pool) T(...)" and
+// "new (arena) T(...)", in the same way as "new (SYSTEM) T(...)".
+
+#ifndef __pool_h
+#define __pool_h
+
+#include <cpu.h>
+#include <utility/spin.h>
+#include <utility/heap.h>
+
+__BEGIN_UTIL
+
+template<typename T, unsigned int N, bool cached = false>
+class Pool
+{
+private:
+    static const unsigned int CPUS = cached ? Traits<Build>::CPUS : 1;
+    static const unsigned int CACHE_SIZE = 8;
+
+    union Slot {
+        char object[sizeof(T)];
+        Slot * next;
+    } __attribute__((aligned(__alignof__(T))));
+
+    struct Cache {
+        Slot * head;
+        unsigned int count;
+        volatile bool lock;
+    };
+
+public:
+    typedef T Object_Type;
+
+public:
+    Pool(): _free(0), _available(N) {
+        for(int i = N - 1; i >= 0; i--) {
+            _slot[i].next = _free;
+            _free = &_slot[i];
+        }
+        for(unsigned int i = 0; i < CPUS; i++) {
+            _cache[i].head = 0;
+            _cache[i].count = 0;
+            _cache[i].lock = false;
+        }
+    }
+
+    void * alloc() {
+        Slot * s;
+
+        bool ints = CPU::int_enabled();
+        CPU::int_disable();
+
+        if(cached) {
+            unsigned int me = This_CPU::id();
+            Cache * c = &_cache[me];
+            lock(c);
+            if(!c->head) {
+                _lock.acquire();
+                for(unsigned int i = 0; (i < CACHE_SIZE / 2) && _free; i++) {
+                    s = _free;
+                    _free = s->next;
+                    s->next = c->head;
+                    c->head = s;
+                    c->count++;
+                }
+                _lock.release();
+            }
+            s = take(c);
+            unlock(c);
+
+            // The shared list is empty too, but slots freed on other CPUs may still sit in their caches
+            for(unsigned int i = 1; !s && (i < CPUS); i++) {
+                c = &_cache[(me + i) % CPUS];
+                lock(c);
+                s = take(c);
+                unlock(c);
+            }
+        } else {
+            _lock.acquire();
+            s = _free;
+            if(s)
+                _free = s->next;
+            _lock.release();
+        }
+
+        if(s)
+            CPU::fdec(_available);
+
+        if(ints)
+            CPU::int_enable();
+
+        db<Heaps>(TRC) << "Pool::alloc(this=" << this << ") => " << reinterpret_cast<void *>(s) << endl;
+
+        return s;
+    }
+
+    void free(void * ptr) {
+        db<Heaps>(TRC) << "Pool::free(this=" << this << ",ptr=" << ptr << ")" << endl;
+
+        if(!ptr)
+            return;
+
+        Slot * s = reinterpret_cast<Slot *>(ptr);
+
+        bool ints = CPU::int_enabled();
+        CPU::int_disable();
+
+        CPU::finc(_available);
+
+        if(cached) {
+            Cache * c = &_cache[This_CPU::id()];
+            lock(c);
+            s->next = c->head;
+            c->head = s;
+            if(++c->count > CACHE_SIZE) {
+                _lock.acquire();
+                for(unsigned int i = 0; i < CACHE_SIZE / 2; i++) {
+                    s = c->head;
+                    c->head = s->next;
+                    c->count--;
+                    s->next = _free;
+                    _free = s;
+                }
+                _lock.release();
+            }
+            unlock(c);
+        } else {
+            _lock.acquire();
+            s->next = _free;
+            _free = s;
+            _lock.release();
+        }
+
+        if(ints)
+            CPU::int_enable();
+    }
+
+    // Runs the object's destructor and gives its slot back
+    void destroy(T * object) {
+        if(object) {
+            object->~T();
+            free(object);
+        }
+    }
+
+    bool contains(const void * ptr) const {
+        return (ptr >= &_slot[0]) && (ptr < &_slot[N]);
+    }
+
+    unsigned int size() const { return N; }
+    unsigned int available() const { return _available; }
+
+private:
+    // Cache locks are taken with interrupts disabled and never nested (the shared lock comes after them)
+    static void lock(Cache * c) { while(CPU::tsl(c->lock)); }
+    static void unlock(Cache * c) { c->lock = false; }
+
+    static Slot * take(Cache * c) {
+        Slot * s = c->head;
+        if(s) {
+            c->head = s->next;
+            c->count--;
+        }
+        return s;
+    }
+
+private:
+    Slot _slot[N];
+    Slot * _free;
+    Cache _cache[CPUS];
+    volatile int _available;
+    Spin _lock;
+};
+
+
+class Arena
+{
+public:
+    Arena(void * addr, unsigned int bytes): _base(reinterpret_cast<char *>(addr)), _size(bytes), _top(0) {
+        db<Heaps>(TRC) << "Arena(addr=" << addr << ",bytes=" << bytes << ") => " << this << endl;
+    }
+
+    // Lock-free: concurrent callers race for the top with compare-and-swap
+    void * alloc(unsigned int bytes) {
+        bytes = (bytes + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+
+        int top, next;
+        do {
+            top = _top;
+            next = top + bytes;
+            if(!bytes || (static_cast<unsigned int>(next) > _size)) {
+                db<Heaps>(WRN) << "Arena::alloc(this=" << this << ",bytes=" << bytes << ") => 0" << endl;
+                return 0;
+            }
+        } while(CPU::cas(_top, top, next) != top);
+
+        return _base + top;
+    }
+
+    // Releases everything allocated so far; no destructors are run
+    void reset() { _top = 0; }
+
+    bool contains(const void * ptr) const {
+        return (ptr >= _base) && (ptr < _base + _size);
+    }
+
+    unsigned int size() const { return _size; }
+    unsigned int used() const { return _top; }
+
+private:
+    char * _base;
+    unsigned int _size;
+    volatile int _top;
+};
+
+__END_UTIL
+
+// Both return 0 when exhausted; the empty exception specifications make the
+// compiler skip the constructor in that case
+template<typename T, unsigned int N, bool cached>
+inline void * operator new(size_t bytes, _UTIL::Pool<T, N, cached> & pool) throw() {
+    return (bytes <= sizeof(T)) ? pool.alloc() : 0;
+}
+
+inline void * operator new(size_t bytes, _UTIL::Arena & arena) throw() {
+    return arena.alloc(bytes);
+}
+
+inline void * operator new[](size_t bytes, _UTIL::Arena & arena) throw() {
+    return arena.alloc(bytes);
+}
+
+#endif
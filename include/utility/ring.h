@@ -0,0 +1,229 @@
+// EPOS Lock-free Ring Utility Declarations
+
+// SPSC_Ring is a bounded, single-producer, single-consumer ring buffer. The
+// producer owns the tail and the consumer owns the head, so neither side
+// needs atomic read-modify-write operations.
+
+// MPMC_Queue is a bounded, multi-producer, multi-consumer queue in which each
+// cell carries a sequence number telling whether it is ready to be written or
+// read. Producers and consumers claim positions with CPU::cas.
+
+// In both, head and tail live in separate cache lines to avoid false sharing
+// between producers and consumers. N must be a power of 2.
+
+// Blocking_Queue wraps either of them and only touches the synchronizer S
+// (e.g. Semaphore) when the queue is actually empty or full.
+
+#ifndef __ring_h
+#define __ring_h
+
+#include <cpu.h>
+
+__BEGIN_UTIL
+
+// Single-Producer, Single-Consumer Ring
+template<typename T, unsigned int N>
+class SPSC_Ring
+{
+private:
+    static const unsigned int MASK = N - 1;
+    static const unsigned int PAD = Traits<CPU>::CACHE_LINE_SIZE - sizeof(unsigned int);
+
+    static_assert(N && !(N & (N - 1)), "N must be a power of 2");
+
+public:
+    typedef T Object_Type;
+
+public:
+    SPSC_Ring(): _head(0), _tail(0) {}
+
+    bool empty() const { return _head == _tail; }
+    bool full() const { return (_tail - _head) == N; }
+    unsigned int size() const { return _tail - _head; }
+
+    bool insert(const T & o) {
+        unsigned int tail = _tail;
+        if((tail - _head) == N)
+            return false;
+        _buffer[tail & MASK] = o;
+        ASM("" : : : "memory"); // publish the object before the tail
+        _tail = tail + 1;
+        return true;
+    }
+
+    bool remove(T * o) {
+        unsigned int head = _head;
+        if(head == _tail)
+            return false;
+        *o = _buffer[head & MASK];
+        ASM("" : : : "memory"); // consume the object before releasing the slot
+        _head = head + 1;
+        return true;
+    }
+
+private:
+    volatile unsigned int _head;
+    char _head_pad[PAD];
+    volatile unsigned int _tail;
+    char _tail_pad[PAD];
+    T _buffer[N];
+};
+
+
+// Multi-Producer, Multi-Consumer Queue
+template<typename T, unsigned int N>
+class MPMC_Queue
+{
+private:
+    static const unsigned int MASK = N - 1;
+    static const unsigned int PAD = Traits<CPU>::CACHE_LINE_SIZE - sizeof(unsigned int);
+
+    struct Cell {
+        volatile unsigned int sequence;
+        T object;
+    };
+
+    static_assert(N && !(N & (N - 1)), "N must be a power of 2");
+
+public:
+    typedef T Object_Type;
+
+public:
+    MPMC_Queue(): _head(0), _tail(0) {
+        for(unsigned int i = 0; i < N; i++)
+            _cells[i].sequence = i;
+    }
+
+    bool empty() const { return _head == _tail; }
+    unsigned int size() const { return _tail - _head; }
+
+    bool insert(const T & o) {
+        Cell * c;
+        unsigned int pos = _tail;
+        for(;;) {
+            c = &_cells[pos & MASK];
+            int dif = int(c->sequence) - int(pos);
+            if(dif == 0) {
+                if(CPU::cas(_tail, pos, pos + 1) == pos)
+                    break;
+                pos = _tail;
+            } else if(dif < 0)
+                return false; // full
+            else
+                pos = _tail;
+        }
+        c->object = o;
+        ASM("" : : : "memory");
+        c->sequence = pos + 1;
+        return true;
+    }
+
+    bool remove(T * o) {
+        Cell * c;
+        unsigned int pos = _head;
+        for(;;) {
+            c = &_cells[pos & MASK];
+            int dif = int(c->sequence) - int(pos + 1);
+            if(dif == 0) {
+                if(CPU::cas(_head, pos, pos + 1) == pos)
+                    break;
+                pos = _head;
+            } else if(dif < 0)
+                return false; // empty
+            else
+                pos = _head;
+        }
+        *o = c->object;
+        ASM("" : : : "memory");
+        c->sequence = pos + N;
+        return true;
+    }
+
+private:
+    volatile unsigned int _head;
+    char _head_pad[PAD];
+    volatile unsigned int _tail;
+    char _tail_pad[PAD];
+    Cell _cells[N];
+};
+
+
+// Blocking wrapper for SPSC_Ring and MPMC_Queue
+// Threads register themselves as sleepers before blocking on S and re-check
+// the queue afterwards, so a wakeup is never lost. A spurious wakeup only
+// costs another round in the loop. The counters of sleepers are read with a
+// locked operation after publishing, since IA32 would otherwise let the load
+// pass the store still in the write buffer and both sides would miss each other.
+template<typename Q, typename S>
+class Blocking_Queue
+{
+public:
+    typedef typename Q::Object_Type Object_Type;
+
+public:
+    Blocking_Queue(): _items(0), _slots(0), _consumers(0), _producers(0) {}
+
+    bool empty() const { return _queue.empty(); }
+    unsigned int size() const { return _queue.size(); }
+
+    bool try_insert(const Object_Type & o) {
+        if(!_queue.insert(o))
+            return false;
+        if(sleepers(_consumers))
+            _items.v();
+        return true;
+    }
+
+    bool try_remove(Object_Type * o) {
+        if(!_queue.remove(o))
+            return false;
+        if(sleepers(_producers))
+            _slots.v();
+        return true;
+    }
+
+    void insert(const Object_Type & o) {
+        while(!_queue.insert(o)) {
+            CPU::finc(_producers);
+            if(_queue.insert(o)) {
+                CPU::fdec(_producers);
+                break;
+            }
+            _slots.p();
+            CPU::fdec(_producers);
+        }
+        if(sleepers(_consumers))
+            _items.v();
+    }
+
+    Object_Type remove() {
+        Object_Type o;
+        while(!_queue.remove(&o)) {
+            CPU::finc(_consumers);
+            if(_queue.remove(&o)) {
+                CPU::fdec(_consumers);
+                break;
+            }
+            _items.p();
+            CPU::fdec(_consumers);
+        }
+        if(sleepers(_producers))
+            _slots.v();
+        return o;
+    }
+
+private:
+    // Full barrier and load (compare-and-swap of 0 by 0 leaves the counter as it is)
+    static int sleepers(volatile int & counter) { return CPU::cas(counter, 0, 0); }
+
+private:
+    Q _queue;
+    S _items;
+    S _slots;
+    volatile int _consumers;
+    volatile int _producers;
+};
+
+__END_UTIL
+
+#endif
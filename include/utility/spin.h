@@ -4,15 +4,18 @@
 #define __spin_h
 
 #include <cpu.h>
+#include <utility/lock_profiler.h>
 
 __BEGIN_UTIL
 
-// Forwarder to the running thread id
+// Forwarder to the running thread id and lock state
 class This_Thread
 {
 public:
     static unsigned int id();
+    static bool locked();
     static void not_booting() { _not_booting = true; }
+    static bool booting() { return !_not_booting; }
 
 private:
     static bool _not_booting; 
@@ -21,13 +24,25 @@ private:
 // Recursive Spin Lock
 class Spin
 {
+private:
+    static const bool profiled = Traits<Spin>::profiled;
+
 public:
     Spin(): _level(0), _owner(0) {}
 
+    void name(const char * n) { _profile.name(n); }
+
     void acquire() {
         int me = This_Thread::id();
-        while(CPU::cas(_owner, 0, me) != me);
-        _level++;
+        int owner = CPU::cas(_owner, 0, me);
+        if(profiled && owner && (owner != me)) {
+            Lock_Profile<profiled>::Time_Stamp t0 = _profile.time_stamp();
+            while(CPU::cas(_owner, 0, me) != me);
+            _profile.contended(owner, _profile.time_stamp() - t0);
+        } else
+            while(CPU::cas(_owner, 0, me) != me);
+        if(!_level++)
+            _profile.acquired(me);
 
         db<Spin>(TRC) << "Spin::acquire(this=" << this << ",id=" << me << ") => {owner=" << _owner << ",level=" << _level << "}" << endl;
     }
@@ -42,6 +57,7 @@ public:
 private:
     volatile unsigned int _level;
     volatile int _owner;
+    Lock_Profile<profiled> _profile;
 };
 
 __END_UTIL
@@ -0,0 +1,331 @@
+// EPOS Two-Level Segregated Fit (TLSF) Free Block Index Utility Declarations
+
+// TLSF indexes free memory blocks by size in two levels: the first splits
+// sizes in powers of two, the second splits each power of two in SL_LISTS
+// linear ranges. A bitmap per level tells which lists are not empty, so
+// finding a good fit takes a couple of bit scans and never walks a list.
+// Every block starts with a tag holding its size and two flags: whether it
+// is free and whether the block right before it is free. Free blocks also
+// repeat their size in their last word (boundary tag), so freeing a block
+// merges it with both neighbors in constant time, without address searches.
+// Each region added to the index ends in a zero-sized used tag (sentinel).
+// Aligned allocations and in-place resizes split the excess off a block and
+// give it back through the same path as free(), so it merges with neighbors.
+// TLSF is not synchronized; Heap serializes its calls.
+
+#ifndef __tlsf_h
+#define __tlsf_h
+
+#include <cpu.h>
+#include <utility/ostream.h>
+
+__BEGIN_UTIL
+
+class TLSF
+{
+private:
+    static const unsigned int SL_BITS = 4;
+    static const unsigned int SL_LISTS = 1 << SL_BITS;
+    static const unsigned int FL_LISTS = sizeof(unsigned int) * 8;
+
+    static const unsigned int FREE = 1 << 0;
+    static const unsigned int PREV_FREE = 1 << 1;
+    static const unsigned int FLAGS = FREE | PREV_FREE;
+
+    struct Block {
+        unsigned int size() const { return _tag & ~FLAGS; }
+        void size(unsigned int s) { _tag = s | (_tag & FLAGS); }
+
+        bool free() const { return _tag & FREE; }
+        bool prev_free() const { return _tag & PREV_FREE; }
+        void free(bool f) { _tag = f ? (_tag | FREE) : (_tag & ~FREE); }
+        void prev_free(bool f) { _tag = f ? (_tag | PREV_FREE) : (_tag & ~PREV_FREE); }
+
+        void * payload() { return &_prev; }
+        Block * next() { return reinterpret_cast<Block *>(reinterpret_cast<char *>(payload()) + size()); }
+        Block * prev() { return reinterpret_cast<Block *>(reinterpret_cast<char *>(this) - *(reinterpret_cast<unsigned int *>(this) - 1) - sizeof(_tag)); }
+        void footer() { *reinterpret_cast<unsigned int *>(reinterpret_cast<char *>(payload()) + size() - sizeof(unsigned int)) = size(); }
+
+        static Block * of(void * payload) { return reinterpret_cast<Block *>(reinterpret_cast<char *>(payload) - sizeof(unsigned int)); }
+
+        unsigned int _tag;
+        Block * _prev; // free blocks only
+        Block * _next;
+    };
+
+public:
+    static const unsigned int OVERHEAD = sizeof(unsigned int);      // tag of each block
+    static const unsigned int MIN_SIZE = SL_LISTS;                  // smallest payload (links and footer)
+    static const unsigned int MAX_SIZE = 1U << (FL_LISTS - 1);
+
+public:
+    TLSF(): _fl_map(0), _free(0), _blocks(0) {
+        for(unsigned int i = 0; i < FL_LISTS; i++) {
+            _sl_map[i] = 0;
+            for(unsigned int j = 0; j < SL_LISTS; j++)
+                _head[i][j] = 0;
+        }
+    }
+
+    // Adds the region [addr, addr + bytes) to the index
+    void insert(void * addr, unsigned int bytes) {
+        bytes &= ~(sizeof(unsigned int) - 1);
+        if(bytes < OVERHEAD + MIN_SIZE + OVERHEAD)
+            return;
+
+        Block * b = reinterpret_cast<Block *>(addr);
+        b->_tag = 0;
+        b->size(bytes - OVERHEAD - OVERHEAD);
+
+        Block * sentinel = b->next();
+        sentinel->_tag = 0;
+
+        insert(b);
+    }
+
+    // Returns a payload of at least "bytes" bytes or 0
+    void * alloc(unsigned int bytes) {
+        bytes = round(bytes);
+        if(bytes >= MAX_SIZE)
+            return 0;
+
+        unsigned int fl, sl;
+        map(bytes + (1 << (CPU::bsr(bytes) - SL_BITS)) - 1, &fl, &sl); // round up to the next list so any block found fits
+
+        Block * b = find(&fl, &sl);
+        if(!b)
+            return 0;
+
+        remove(b, fl, sl);
+
+        // Split off the remainder if it can hold a block of its own
+        if(b->size() >= bytes + OVERHEAD + MIN_SIZE) {
+            Block * r = reinterpret_cast<Block *>(reinterpret_cast<char *>(b->payload()) + bytes);
+            r->_tag = 0;
+            r->size(b->size() - bytes - OVERHEAD);
+            b->size(bytes);
+            insert(r);
+        } else
+            b->next()->prev_free(false);
+
+        b->free(false);
+
+        return b->payload();
+    }
+
+    // Returns a payload of at least "bytes" bytes whose address plus "offset"
+    // is a multiple of "align" (a power of two) or 0. The block is taken with
+    // room for the misalignment, which is then split off on both ends and
+    // given back, so no memory is wasted beyond a regular alloc().
+    void * alloc(unsigned int bytes, unsigned int align, unsigned int offset) {
+        if((align <= sizeof(unsigned int)) && !(offset % align))
+            return alloc(bytes);
+
+        bytes = round(bytes);
+        char * p = reinterpret_cast<char *>(alloc(bytes + align + OVERHEAD + MIN_SIZE));
+        if(!p)
+            return 0;
+
+        // A prefix must be large enough to be a free block of its own
+        char * a = reinterpret_cast<char *>(((reinterpret_cast<unsigned int>(p) + offset + align - 1) & ~(align - 1)) - offset);
+        while((a != p) && (static_cast<unsigned int>(a - p) < OVERHEAD + MIN_SIZE))
+            a += align;
+
+        Block * b = Block::of(p);
+        if(a != p) {
+            Block * n = Block::of(a);
+            n->_tag = 0;
+            n->size(b->size() - (a - p));
+            b->size(a - p - OVERHEAD);
+            free(p);
+            b = n;
+        }
+
+        trim(b, bytes);
+
+        return b->payload();
+    }
+
+    // Grows (into the free block right after it) or shrinks a payload returned
+    // by alloc() in place, returning false if it cannot hold "bytes" bytes
+    bool resize(void * ptr, unsigned int bytes) {
+        bytes = round(bytes);
+        Block * b = Block::of(ptr);
+
+        if(b->size() < bytes) {
+            Block * n = b->next();
+            if(!n->free() || (b->size() + OVERHEAD + n->size() < bytes))
+                return false;
+            remove(n);
+            b->size(b->size() + OVERHEAD + n->size());
+        }
+
+        trim(b, bytes);
+
+        return true;
+    }
+
+    // Gives back a payload returned by alloc(), merging it with free neighbors
+    void free(void * ptr) {
+        Block * b = Block::of(ptr);
+
+        Block * n = b->next();
+        if(n->free()) {
+            remove(n);
+            b->size(b->size() + OVERHEAD + n->size());
+        }
+
+        if(b->prev_free()) {
+            Block * p = b->prev();
+            remove(p);
+            p->size(p->size() + OVERHEAD + b->size());
+            b = p;
+        }
+
+        insert(b);
+    }
+
+    // Whether the region [addr, addr + bytes) added by insert() is entirely free
+    bool unused(void * addr, unsigned int bytes) const {
+        bytes &= ~(sizeof(unsigned int) - 1);
+        const Block * b = reinterpret_cast<const Block *>(addr);
+        return b->free() && (b->size() == bytes - OVERHEAD - OVERHEAD);
+    }
+
+    // Takes the region [addr, addr + bytes) added by insert() back out of the
+    // index, which only succeeds if the whole region is free
+    bool release(void * addr, unsigned int bytes) {
+        if(!unused(addr, bytes))
+            return false;
+
+        remove(reinterpret_cast<Block *>(addr));
+        return true;
+    }
+
+    // Size actually reserved for a payload returned by alloc()
+    static unsigned int size(void * ptr) { return Block::of(ptr)->size(); }
+
+    bool empty() const { return !_fl_map; }
+    unsigned int free_bytes() const { return _free; }
+    unsigned int blocks() const { return _blocks; }
+
+    unsigned int largest() {
+        if(!_fl_map)
+            return 0;
+        unsigned int fl = CPU::bsr(_fl_map);
+        unsigned int sl = CPU::bsr(_sl_map[fl]);
+        unsigned int max = 0;
+        for(Block * b = _head[fl][sl]; b; b = b->_next)
+            if(b->size() > max)
+                max = b->size();
+        return max;
+    }
+
+    void dump(OStream & os) {
+        for(unsigned int i = 0; i < FL_LISTS; i++)
+            for(unsigned int j = 0; j < SL_LISTS; j++)
+                if(_head[i][j]) {
+                    os << " [" << (1U << i) + (j << (i - SL_BITS)) << "+:";
+                    for(Block * b = _head[i][j]; b; b = b->_next)
+                        os << " " << b->payload() << "/" << b->size();
+                    os << "]";
+                }
+    }
+
+private:
+    static unsigned int round(unsigned int bytes) {
+        bytes = (bytes + sizeof(unsigned int) - 1) & ~(sizeof(unsigned int) - 1);
+        return (bytes < MIN_SIZE) ? MIN_SIZE : bytes;
+    }
+
+    // Gives the tail of used block b beyond "bytes" back, if it can hold a block of its own
+    void trim(Block * b, unsigned int bytes) {
+        if(b->size() < bytes + OVERHEAD + MIN_SIZE)
+            return;
+
+        Block * r = reinterpret_cast<Block *>(reinterpret_cast<char *>(b->payload()) + bytes);
+        r->_tag = 0;
+        r->size(b->size() - bytes - OVERHEAD);
+        b->size(bytes);
+        free(r->payload());
+    }
+
+    static void map(unsigned int bytes, unsigned int * fl, unsigned int * sl) {
+        *fl = CPU::bsr(bytes);
+        *sl = (bytes >> (*fl - SL_BITS)) & (SL_LISTS - 1);
+    }
+
+    // Finds a non-empty list at (fl, sl) or above, updating both
+    Block * find(unsigned int * fl, unsigned int * sl) {
+        unsigned int sl_map = _sl_map[*fl] & (~0U << *sl);
+        if(!sl_map) {
+            unsigned int fl_map = (*fl + 1 < FL_LISTS) ? _fl_map & (~0U << (*fl + 1)) : 0;
+            if(!fl_map)
+                return 0;
+            *fl = CPU::bsf(fl_map);
+            sl_map = _sl_map[*fl];
+        }
+        *sl = CPU::bsf(sl_map);
+
+        return _head[*fl][*sl];
+    }
+
+    void insert(Block * b) {
+        unsigned int fl, sl;
+        map(b->size(), &fl, &sl);
+
+        b->_prev = 0;
+        b->_next = _head[fl][sl];
+        if(b->_next)
+            b->_next->_prev = b;
+        _head[fl][sl] = b;
+
+        _fl_map |= 1U << fl;
+        _sl_map[fl] |= 1U << sl;
+
+        b->free(true);
+        b->footer();
+        b->next()->prev_free(true);
+
+        _free += b->size();
+        _blocks++;
+    }
+
+    void remove(Block * b) {
+        unsigned int fl, sl;
+        map(b->size(), &fl, &sl);
+        remove(b, fl, sl);
+    }
+
+    void remove(Block * b, unsigned int fl, unsigned int sl) {
+        if(b->_prev)
+            b->_prev->_next = b->_next;
+        else
+            _head[fl][sl] = b->_next;
+        if(b->_next)
+            b->_next->_prev = b->_prev;
+
+        if(!_head[fl][sl]) {
+            _sl_map[fl] &= ~(1U << sl);
+            if(!_sl_map[fl])
+                _fl_map &= ~(1U << fl);
+        }
+
+        b->free(false);
+        b->next()->prev_free(false);
+
+        _free -= b->size();
+        _blocks--;
+    }
+
+private:
+    unsigned int _fl_map;
+    unsigned int _sl_map[FL_LISTS];
+    Block * _head[FL_LISTS][SL_LISTS];
+    unsigned int _free;
+    unsigned int _blocks;
+};
+
+__END_UTIL
+
+#endif
@@ -0,0 +1,164 @@
+// EPOS Hierarchical Timing Wheel Utility Declarations
+
+// Timing_Wheel keeps timed elements in LEVELS wheels of 2^BITS slots each.
+// Level 0 has one slot per tick; each slot of level l spans 2^(BITS * l)
+// ticks. An element is put in the lowest level whose span still reaches its
+// expiry, in the slot given by the corresponding digits of its expiry tick,
+// so insertion and removal are O(1) and do not depend on how many elements
+// are pending. Whenever the time wraps a level, the current slot of the level
+// above is emptied into the lower ones (cascading), so elements get closer to
+// level 0 as their expiry approaches. Elements further away than the whole
+// wheel wait in the top level and are cascaded again until they fit.
+// Each tick moves the elements of the current level 0 slot to a list of
+// expired elements, which callers drain with expired().
+// Elements are intrusive: objects embed a Timing_Wheel::Element.
+// Timing_Wheel is not synchronized.
+
+#ifndef __wheel_h
+#define __wheel_h
+
+#include <system/config.h>
+
+__BEGIN_UTIL
+
+template<typename T, typename Tick = unsigned int, unsigned int LEVELS = 4, unsigned int BITS = 6>
+class Timing_Wheel
+{
+private:
+    static const unsigned int SLOTS = 1 << BITS;
+    static const unsigned int MASK = SLOTS - 1;
+    static const Tick SPAN = static_cast<Tick>(1) << (BITS * LEVELS); // ticks covered by the whole wheel
+
+public:
+    typedef T Object_Type;
+
+    class Element
+    {
+        friend class Timing_Wheel;
+
+    public:
+        Element(const T * o): _object(o), _expiry(0), _prev(0), _next(0), _list(0) {}
+
+        T * object() const { return const_cast<T *>(_object); }
+
+        const Tick & expiry() const { return _expiry; }
+        bool linked() const { return _list; }
+
+        Element * next() const { return _next; }
+
+    private:
+        const T * _object;
+        Tick _expiry;
+        Element * _prev;
+        Element * _next;
+        Element ** _list; // head of the slot (or of the expired list) the element is in
+    };
+
+public:
+    Timing_Wheel(): _now(0), _size(0), _expired(0) {
+        for(unsigned int i = 0; i < LEVELS; i++)
+            for(unsigned int j = 0; j < SLOTS; j++)
+                _slot[i][j] = 0;
+    }
+
+    const Tick & now() const { return _now; }
+
+    bool empty() const { return !_size; }
+    unsigned int size() const { return _size; }
+
+    // Schedules e to expire in "ticks" ticks (at least one)
+    void insert(Element * e, const Tick & ticks) {
+        e->_expiry = _now + (ticks ? ticks : 1);
+        place(e);
+        _size++;
+    }
+
+    void remove(Element * e) {
+        if(!e->linked())
+            return;
+        unlink(e);
+        _size--;
+    }
+
+    // Advances the time by one tick, moving the elements that expire at the
+    // new time to the expired list
+    void tick() {
+        _now++;
+
+        // Cascade each level whose lower levels have just wrapped
+        for(unsigned int l = 1; (l < LEVELS) && !(_now & ((static_cast<Tick>(1) << (BITS * l)) - 1)); l++) {
+            Element ** slot = &_slot[l][(_now >> (BITS * l)) & MASK];
+            Element * e = *slot;
+            *slot = 0;
+            while(e) {
+                Element * n = e->_next;
+                place(e);
+                e = n;
+            }
+        }
+
+        Element ** slot = &_slot[0][_now & MASK];
+        Element * e = *slot;
+        *slot = 0;
+        while(e) {
+            Element * n = e->_next;
+            link(e, &_expired);
+            e = n;
+        }
+    }
+
+    // Removes and returns an expired element, or 0 if none is left
+    Element * expired() {
+        Element * e = _expired;
+        if(e) {
+            unlink(e);
+            _size--;
+        }
+        return e;
+    }
+
+private:
+    // Puts e in the lowest level that reaches its expiry
+    void place(Element * e) {
+        Tick delta = e->_expiry - _now;
+        Tick when = e->_expiry;
+        if(delta >= SPAN) // beyond the wheel: park it at the farthest top-level slot
+            when = _now + SPAN - 1;
+
+        unsigned int l = 0;
+        for(delta = when - _now; (l < LEVELS - 1) && (delta >= (static_cast<Tick>(1) << (BITS * (l + 1)))); l++);
+
+        link(e, &_slot[l][(when >> (BITS * l)) & MASK]);
+    }
+
+    void link(Element * e, Element ** list) {
+        e->_list = list;
+        e->_prev = 0;
+        e->_next = *list;
+        if(*list)
+            (*list)->_prev = e;
+        *list = e;
+    }
+
+    void unlink(Element * e) {
+        if(e->_prev)
+            e->_prev->_next = e->_next;
+        else
+            *e->_list = e->_next;
+        if(e->_next)
+            e->_next->_prev = e->_prev;
+        e->_list = 0;
+        e->_prev = 0;
+        e->_next = 0;
+    }
+
+private:
+    Tick _now;
+    unsigned int _size;
+    Element * _expired;
+    Element * _slot[LEVELS][SLOTS];
+};
+
+__END_UTIL
+
+#endif
@@ -2,6 +2,7 @@
 
 #include <semaphore.h>
 #include <alarm.h>
+#include <clock.h>
 #include <display.h>
 
 __BEGIN_SYS
@@ -9,22 +10,25 @@ __BEGIN_SYS
 // Class attributes
 Alarm_Timer * Alarm::_timer;
 volatile Alarm::Tick Alarm::_elapsed;
-Alarm::Queue Alarm::_request;
+Alarm::Queue Alarm::_request[Traits<Build>::CPUS];
+Alarm::Deferred Alarm::_deferred[Traits<Build>::CPUS];
+Alarm::Imminent Alarm::_imminent[Traits<Build>::CPUS];
+Alarm::Time_Stamp Alarm::_tick[Traits<Build>::CPUS];
 
 
 // Methods
-Alarm::Alarm(const Microsecond & time, Handler * handler, int times)
-: _ticks(ticks(time)), _handler(handler), _times(times), _link(this, _ticks)
+Alarm::Alarm(const Microsecond & time, Handler * handler, int times, const Microsecond & slack)
+: _time(time), _ticks(ticks(time)), _slack(slack / period()), _due(0), _handler(handler), _times(times), _repeat(times), _link(this), _deferred_link(this), _cpu(0), _deferred_in(0), _runs(0),
+  _deadline(0), _period(high_resolution ? cycles(time) : 0), _slack_ts(high_resolution ? cycles(slack) : 0), _imminent_link(this, 0), _imminent_in(0)
 {
     lock();
 
     db<Alarm>(TRC) << "Alarm(t=" << time << ",tk=" << _ticks << ",h=" << reinterpret_cast<void *>(handler)
-                   << ",x=" << times << ") => " << this << endl;
+                   << ",x=" << times << ",s=" << slack << ") => " << this << endl;
 
-    if(_ticks) {
-        _request.insert(&_link);
+    if(start())
         unlock();
-    } else {
+    else {
         unlock();
         (*handler)();
     }
@@ -37,12 +41,129 @@ Alarm::~Alarm()
 
     db<Alarm>(TRC) << "~Alarm(this=" << this << ")" << endl;
 
-    _request.remove(this);
+    dequeue();
+    if(_deferred_in)
+        _deferred_in->remove(&_deferred_link);
+
+    unlock();
+}
+
+
+// Re-arms the alarm to expire "time" from now (and every "time" thereafter, as many times as it was created for),
+// wherever it was in its queue or even if it had already expired or been canceled. Expirations whose handlers are
+// pending still run.
+void Alarm::reset(const Microsecond & time)
+{
+    lock();
+
+    db<Alarm>(TRC) << "Alarm::reset(this=" << this << ",t=" << time << ")" << endl;
+
+    dequeue();
+
+    _time = time;
+    _ticks = ticks(time);
+    if(high_resolution)
+        _period = cycles(time);
+    _times = _repeat;
+
+    if(start())
+        unlock();
+    else {
+        Handler * handler = _handler;
+        unlock();
+        (*handler)();
+    }
+}
+
+
+// Takes the alarm out of its queue and drops the expirations whose handlers have not run yet. A handler that another
+// CPU has already started is not interrupted. The alarm can be armed again with reset().
+void Alarm::cancel()
+{
+    lock();
+
+    db<Alarm>(TRC) << "Alarm::cancel(this=" << this << ")" << endl;
+
+    dequeue();
+    if(_deferred_in) {
+        _deferred_in->remove(&_deferred_link);
+        _deferred_in = 0;
+        _runs = 0;
+    }
+
+    unlock();
+}
+
+
+// Changes the period of a periodic alarm from its next expiry on, which stays where it is. A zero period means a tick.
+void Alarm::period(const Microsecond & time)
+{
+    lock();
+
+    db<Alarm>(TRC) << "Alarm::period(this=" << this << ",t=" << time << ")" << endl;
+
+    _time = time ? time : period();
+    _ticks = ticks(_time);
+    if(high_resolution)
+        _period = cycles(_time);
 
     unlock();
 }
 
 
+// Time left to the next expiry (0 if the alarm is not armed)
+Alarm::Microsecond Alarm::remaining()
+{
+    Microsecond time = 0;
+
+    lock();
+
+    if(high_resolution) {
+        if(_link.linked() || _imminent_in) {
+            Time_Stamp now = TSC::time_stamp();
+            if(_deadline > now)
+                time = Clock::microseconds(_deadline - now);
+        }
+    } else if(_link.linked())
+        time = (_link.expiry() - _request[_cpu].now()) * period();
+
+    unlock();
+
+    return time;
+}
+
+
+// Queues the alarm on this CPU to expire one period from now, or returns false if the period is zero (lock held).
+// Alarms expire on the CPU of the thread that arms them, so their handlers (and the threads they wake up) stay there.
+bool Alarm::start()
+{
+    if(!(high_resolution ? _period : _ticks))
+        return false;
+
+    _cpu = Machine::cpu_id();
+    if(high_resolution) {
+        _deadline = TSC::time_stamp() + _period;
+        arm();
+    } else {
+        _due = _request[_cpu].now() + _ticks;
+        queue();
+    }
+
+    return true;
+}
+
+
+// Takes the alarm out of whichever queue of its CPU holds it (lock held)
+void Alarm::dequeue()
+{
+    _request[_cpu].remove(&_link);
+    if(_imminent_in) {
+        _imminent_in->remove(&_imminent_link);
+        _imminent_in = 0;
+    }
+}
+
+
 // Class methods
 void Alarm::delay(const Microsecond & time)
 {
@@ -59,9 +180,12 @@ void Alarm::handler(const IC::Interrupt_Id & i)
 {
     lock();
 
-    _elapsed++;
+    // Every CPU ticks its own alarm queue, but CPU 0 alone keeps the system-wide elapsed time
+    unsigned int cpu = Machine::cpu_id();
+    if(cpu == 0)
+        _elapsed++;
 
-    if(Traits<Alarm>::visible) {
+    if(Traits<Alarm>::visible && (cpu == 0)) {
         Display display;
         int lin, col;
         display.position(&lin, &col);
@@ -70,29 +194,158 @@ void Alarm::handler(const IC::Interrupt_Id & i)
         display.position(lin, col);
     }
 
-    Alarm * alarm = 0;
-
-    if(!_request.empty()) {
-        // Replacing the following "if" by a "while" loop is tempting, but recovering the lock and dispatching the handler is
-        // troublesome if the Alarm gets destroyed in between, like is the case for the idle thread returning to shutdown the machine
-        if(_request.head()->promote() <= 0) { // rank can be negative whenever multiple handlers get created for the same time tick
-            Queue::Element * e = _request.remove();
-            alarm = e->object();
-            if(alarm->_times != INFINITE)
-                alarm->_times--;
-            if(alarm->_times) {
-                e->rank(alarm->_ticks);
-                _request.insert(e);
-            }
-        }
+    // Advance this CPU's wheel and detach every alarm that expired in this tick. Handlers run in run_deferred(),
+    // out of the lock. High-resolution alarms whose deadlines fall within the coming tick move to the imminent list instead.
+    Time_Stamp now = high_resolution ? TSC::time_stamp() : 0;
+    _tick[cpu] = now;
+    _request[cpu].tick();
+    for(Queue::Element * e; (e = _request[cpu].expired()); ) {
+        Alarm * alarm = e->object();
+        if(high_resolution && (alarm->_deadline > now))
+            alarm->arm();
+        else
+            expire(alarm, cpu);
     }
 
+    if(high_resolution)
+        due(cpu, now);
+
     unlock();
 
-    if(alarm) {
-        db<Alarm>(TRC) << "Alarm::handler(this=" << alarm << ",e=" << _elapsed << ",h=" << reinterpret_cast<void*>(alarm->handler) << ")" << endl;
-        (*alarm->_handler)();
+    run_deferred();
+}
+
+
+// Called by the timer at the deadline of the first imminent alarm of this CPU (high-resolution mode)
+void Alarm::deadline(const IC::Interrupt_Id & i)
+{
+    lock();
+
+    due(Machine::cpu_id(), TSC::time_stamp());
+
+    unlock();
+
+    run_deferred();
+}
+
+
+// Puts a tick-mode alarm in the queue of its CPU to expire at tick _due, rounded up within its slack (lock held).
+// An alarm that is already late (e.g. with a period shorter than its rounding) expires at the next tick.
+void Alarm::queue()
+{
+    Queue * queue = &_request[_cpu];
+
+    Tick at = _due;
+    if(_slack) {
+        Tick granularity = 1 << CPU::bsr(_slack);
+        at = (at + granularity - 1) & ~(granularity - 1);
     }
+
+    Tick n = at - queue->now();
+    if(!n || (n > _ticks + _slack))
+        n = 1;
+
+    queue->insert(&_link, n);
+}
+
+
+// Puts a high-resolution alarm in the queue of its CPU, or in the list of imminent alarms if it is due before the
+// next tick, in which case the timer is asked for an interrupt at the end of its window (lock held). An alarm
+// whose window reaches the first tick after its deadline simply waits for that tick.
+void Alarm::arm()
+{
+    Time_Stamp tick = TSC::frequency() / frequency();
+    Time_Stamp start = _tick[_cpu];
+    Tick n = (_deadline > start) ? (_deadline - start) / tick : 0;
+
+    if(_slack_ts && (_deadline > start)) {
+        Tick first = (_deadline - start + tick - 1) / tick;
+        if(start + first * tick <= _deadline + _slack_ts)
+            n = first;
+    }
+
+    if(n)
+        _request[_cpu].insert(&_link, n);
+    else {
+        _imminent_link.rank(_deadline + _slack_ts);
+        _imminent_in = &_imminent[_cpu];
+        _imminent_in->insert(&_imminent_link);
+        Alarm_Timer::deadline(_imminent[_cpu].head()->rank());
+    }
+}
+
+
+// Expires the imminent alarms of a CPU whose deadlines have passed and asks the timer for the end of the earliest
+// remaining window (lock held). The list is ordered by window end, so every alarm in it must be checked.
+void Alarm::due(unsigned int cpu, const Time_Stamp & now)
+{
+    Imminent * imminent = &_imminent[cpu];
+    for(Imminent::Element * e = imminent->head(), * next; e; e = next) {
+        next = e->next();
+        Alarm * alarm = e->object();
+        if(alarm->_deadline <= now) {
+            imminent->remove(e);
+            alarm->_imminent_in = 0;
+            expire(alarm, cpu);
+        }
+    }
+
+    if(!imminent->empty())
+        Alarm_Timer::deadline(imminent->head()->rank());
+}
+
+
+// Accounts an expiration and queues the handler to run_deferred() (lock held). Periodic alarms are re-armed right away,
+// relative to when they were due (their tick or deadline), so alarms sharing a period do not drift apart.
+void Alarm::expire(Alarm * alarm, unsigned int cpu)
+{
+    if(alarm->_times != INFINITE)
+        alarm->_times--;
+
+    if(alarm->_times) {
+        if(high_resolution) {
+            alarm->_deadline += alarm->_period;
+            alarm->arm();
+        } else {
+            alarm->_due += alarm->_ticks;
+            alarm->queue();
+        }
+    }
+
+    if(!alarm->_runs++) {
+        alarm->_deferred_in = &_deferred[cpu];
+        alarm->_deferred_in->insert(&alarm->_deferred_link);
+    }
+}
+
+
+// Runs the handlers of the alarms expired on this CPU, one expiration per pass. An alarm stays in the list (with the lock
+// held) until its last pending run is taken and is never touched after its handler is called, since the handler may wake up
+// a thread that destroys the alarm (e.g. in delay()) and even switch to that thread right away. Destroying or canceling an
+// alarm that is still in the list just takes it out, dropping the runs left.
+void Alarm::run_deferred()
+{
+    lock();
+
+    Deferred * deferred = &_deferred[Machine::cpu_id()];
+    for(Deferred::Element * e; (e = deferred->head()); ) {
+        Alarm * alarm = e->object();
+        Handler * handler = alarm->_handler;
+        if(!--alarm->_runs) {
+            deferred->remove(e);
+            alarm->_deferred_in = 0;
+        }
+
+        unlock();
+
+        db<Alarm>(TRC) << "Alarm::handler(this=" << alarm << ",e=" << _elapsed << ",h=" << reinterpret_cast<void*>(handler) << ")" << endl;
+
+        (*handler)();
+
+        lock();
+    }
+
+    unlock();
 }
 
 __END_SYS
@@ -10,6 +10,12 @@ void Alarm::init()
     db<Init, Alarm>(TRC) << "Alarm::init()" << endl;
 
     _timer = new (SYSTEM) Alarm_Timer(handler);
+
+    if(high_resolution) {
+        for(unsigned int i = 0; i < Traits<Build>::CPUS; i++)
+            _tick[i] = TSC::time_stamp();
+        Alarm_Timer::deadline_handler(deadline);
+    }
 }
 
 __END_SYS
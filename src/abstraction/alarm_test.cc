@@ -9,15 +9,20 @@ const int iterations = 10;
 
 void func_a(void);
 void func_b(void);
+void func_c(void);
+void func_w(void);
 
 OStream cout;
 
+// Handler runs, checked at the end so that alarms that never expire make the test fail
+volatile int runs_a, runs_b, runs_c, runs_w;
+
 int main()
 {
     cout << "Alarm test" << endl;
 
     cout << "I'm the first thread of the first task created in the system." << endl;
-    cout << "I'll now create two alarms and put myself in a delay ..." << endl;
+    cout << "I'll now create three alarms and put myself in a delay ..." << endl;
 
     Function_Handler handler_a(&func_a);
     Alarm alarm_a(2000000, &handler_a, iterations);
@@ -25,18 +30,42 @@ int main()
     Function_Handler handler_b(&func_b);
     Alarm alarm_b(1000000, &handler_b, iterations);
 
+    // Alarm c may expire up to half a second late, so it can share expiries with a and b
+    Function_Handler handler_c(&func_c);
+    Alarm alarm_c(1000000, &handler_c, iterations, 500000);
+
     // Note that in case of idle-waiting, this thread will go into suspend
     // and the alarm handlers above will trigger the functions in the context
     // of the idle thread!
     Alarm::delay(2000000 * (iterations + 2));
 
+    cout << "Now a watchdog that is kicked before it expires, then canceled and rearmed ..." << endl;
+    Function_Handler handler_w(&func_w);
+    Alarm watchdog(1000000, &handler_w);
+    for(int i = 0; i < iterations; i++) {
+        Alarm::delay(500000);
+        cout << "remaining=" << watchdog.remaining() << " us" << endl;
+        watchdog.reset();
+    }
+    watchdog.cancel();
+    cout << "canceled, remaining=" << watchdog.remaining() << " us (expected 0)" << endl;
+    watchdog.reset(500000);
+    Alarm::delay(1000000);
+
+    cout << "a=" << runs_a << ", b=" << runs_b << ", c=" << runs_c << ", watchdog=" << runs_w
+         << " (expected " << iterations << ", " << iterations << ", " << iterations << ", 1)" << endl;
+
+    bool passed = (runs_a == iterations) && (runs_b == iterations) && (runs_c == iterations) && (runs_w == 1);
+    cout << (passed ? "Passed" : "FAILED") << endl;
+
     cout << "I'm done, bye!" << endl;
 
-    return 0;
+    return passed ? 0 : -1;
 }
 
 void func_a()
 {
+    runs_a++;
     for(int i = 0; i < 79; i++)
         cout << "a";
     cout << endl;
@@ -44,7 +73,22 @@ void func_a()
 
 void func_b(void)
 {
+    runs_b++;
     for(int i = 0; i < 79; i++)
         cout << "b";
     cout << endl;
 }
+
+void func_c(void)
+{
+    runs_c++;
+    for(int i = 0; i < 79; i++)
+        cout << "c";
+    cout << endl;
+}
+
+void func_w(void)
+{
+    runs_w++;
+    cout << "Watchdog expired!" << endl;
+}
@@ -0,0 +1,47 @@
+// EPOS Barrier Abstraction Implementation
+
+#include <barrier.h>
+
+__BEGIN_SYS
+
+Barrier::Barrier(unsigned int n, unsigned int spin): _parties(n), _spin(spin), _count(0), _generation(0)
+{
+    db<Synchronizer>(TRC) << "Barrier(n=" << _parties << ",spin=" << _spin << ") => " << this << endl;
+}
+
+
+Barrier::~Barrier()
+{
+    db<Synchronizer>(TRC) << "~Barrier(this=" << this << ")" << endl;
+}
+
+
+bool Barrier::wait()
+{
+    db<Synchronizer>(TRC) << "Barrier::wait(this=" << this << ",count=" << _count << ",gen=" << _generation << ")" << endl;
+
+    begin_atomic();
+
+    unsigned int generation = _generation;
+    if(++_count >= _parties) {
+        _count = 0;
+        _generation++;
+        wakeup_all(); // implicit end_atomic()
+        return true;
+    }
+
+    if(_spin) {
+        end_atomic();
+        for(unsigned int i = 0; (i < _spin) && (_generation == generation); i++);
+        begin_atomic();
+    }
+
+    if(_generation == generation)
+        sleep(); // implicit end_atomic()
+    else
+        end_atomic();
+
+    return false;
+}
+
+__END_SYS
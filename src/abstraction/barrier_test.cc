@@ -0,0 +1,77 @@
+// EPOS Barrier and Latch Abstractions Test Program
+
+#include <utility/ostream.h>
+#include <thread.h>
+#include <mutex.h>
+#include <barrier.h>
+#include <latch.h>
+
+using namespace EPOS;
+
+const int workers = 4;
+const int phases = 5;
+
+Mutex table;
+Barrier barrier(workers);
+Barrier spinning(workers, 10000);
+Latch started(workers);
+Latch done(workers);
+
+Thread * worker[workers];
+volatile int phase[workers];
+
+OStream cout;
+
+int work(int n)
+{
+    started.count_down();
+
+    for(int i = 0; i < phases; i++) {
+        phase[n] = i;
+
+        bool last = barrier.wait();
+
+        // Everybody must be in the same phase once the barrier opens
+        for(int j = 0; j < workers; j++)
+            if(phase[j] != i) {
+                table.lock();
+                cout << "Worker " << n << " saw worker " << j << " at phase " << phase[j] << " while at phase " << i << "!" << endl;
+                table.unlock();
+            }
+
+        if(last) {
+            table.lock();
+            cout << "Phase " << i << " done (released by worker " << n << " on CPU# " << Machine::cpu_id() << ")" << endl;
+            table.unlock();
+        }
+
+        spinning.wait();
+    }
+
+    done.count_down();
+
+    return phases;
+}
+
+int main()
+{
+    cout << "Barrier and Latch test" << endl;
+
+    for(int i = 0; i < workers; i++)
+        worker[i] = new Thread(&work, i);
+
+    started.wait();
+    cout << "All workers started" << endl;
+
+    done.wait();
+    cout << "All workers done after " << barrier.generation() << " generations" << endl;
+
+    for(int i = 0; i < workers; i++) {
+        worker[i]->join();
+        delete worker[i];
+    }
+
+    cout << "The end!" << endl;
+
+    return 0;
+}
@@ -21,6 +21,8 @@ int main()
     cout << "Chronometer stop." << endl;
 
     cout << "\nElapsed time = " << timepiece.read() << " us" << endl;
+    cout << "Elapsed time = " << timepiece.read_ns() << " ns" << endl;
+    cout << "Clock::now() = " << Clock::now() << " ns since boot" << endl;
 
     return 0;
 }
@@ -0,0 +1,12 @@
+// EPOS Clock Abstraction Implementation
+
+#include <clock.h>
+
+__BEGIN_SYS
+
+// Class attributes
+Clock::Scale Clock::_ns;
+Clock::Scale Clock::_us;
+Clock::Time_Stamp Clock::_offset[Traits<Build>::CPUS];
+
+__END_SYS
@@ -0,0 +1,26 @@
+// EPOS Clock Abstraction Initialization
+
+#include <system.h>
+#include <clock.h>
+
+__BEGIN_SYS
+
+// Called by every CPU at the same point of Init_System
+void Clock::init()
+{
+    unsigned int cpu = Machine::cpu_id();
+
+    if(cpu == 0) {
+        _ns = scale(1000000000, TSC::frequency());
+        _us = scale(1000000, TSC::frequency());
+    }
+
+    // All CPUs leave the barrier together and take their time stamps right away
+    Machine::smp_barrier();
+    _offset[cpu] = TSC::time_stamp();
+    Machine::smp_barrier();
+
+    db<Init, Clock>(TRC) << "Clock::init(offset[" << cpu << "]=" << _offset[cpu] << ",ns=" << _ns.mult << ">>" << _ns.shift << ")" << endl;
+}
+
+__END_SYS
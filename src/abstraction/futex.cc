@@ -0,0 +1,65 @@
+// EPOS Futex Abstraction Implementation
+
+#include <futex.h>
+
+__BEGIN_SYS
+
+// Class attributes
+Futex::Table Futex::_table;
+
+
+// Class methods
+bool Futex::wait(volatile int * addr, int expected)
+{
+    db<Synchronizer>(TRC) << "Futex::wait(addr=" << const_cast<int *>(addr) << ",expected=" << expected << ")" << endl;
+
+    lock();
+
+    if(*addr != expected) {
+        unlock();
+        return false;
+    }
+
+    Thread * self = Thread::running();
+    Waiter waiter(addr);
+    _table.insert(&waiter.link);
+    self->_futex_waiting = true;
+    Thread::sleep(&waiter.queue); // implicit unlock()
+    self->_futex_waiting = false; // wake() has already taken the waiter out of the table
+
+    return true;
+}
+
+
+unsigned int Futex::wake(volatile int * addr, unsigned int n)
+{
+    db<Synchronizer>(TRC) << "Futex::wake(addr=" << const_cast<int *>(addr) << ",n=" << n << ")" << endl;
+
+    lock();
+
+    // Gather the waiters in a local queue and release them with a single wakeup_all()
+    Queue ready;
+    unsigned int woken = 0;
+    for(; woken < n; woken++) {
+        Table::Element * e = _table.remove_key(reinterpret_cast<unsigned int>(addr));
+        if(!e)
+            break;
+        ready.insert(e->object()->queue.remove());
+    }
+
+    Thread::wakeup_all(&ready); // implicit unlock()
+
+    return woken;
+}
+
+
+// Called by ~Thread (lock held) for a thread deleted while waiting in a futex, whose waiter is about to vanish with
+// the thread's stack. The waiter is reached from the queue the thread sleeps on and removed by its own element.
+void Futex::abandon(Thread * thread)
+{
+    Waiter * waiter = Intrusive<Waiter, Queue, &Waiter::queue>::object(thread->_waiting);
+    _table.remove(&waiter->link);
+    thread->_futex_waiting = false;
+}
+
+__END_SYS
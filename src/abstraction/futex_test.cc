@@ -0,0 +1,75 @@
+// EPOS Futex Abstraction Test Program
+
+#include <utility/ostream.h>
+#include <thread.h>
+#include <futex.h>
+
+using namespace EPOS;
+
+const int workers = 4;
+const int iterations = 10000;
+
+OStream cout;
+
+// A library-level lock built on Futex (0 = free, 1 = locked, 2 = contended).
+// Uncontended lock() and unlock() never leave user code.
+class Futex_Lock
+{
+public:
+    Futex_Lock(): _state(0) {}
+
+    void lock() {
+        int c = CPU::cas(_state, 0, 1);
+        if(c)
+            do {
+                if((c == 2) || (CPU::cas(_state, 1, 2) != 0))
+                    Futex::wait(&_state, 2);
+            } while((c = CPU::cas(_state, 0, 2)) != 0);
+    }
+
+    void unlock() {
+        if(CPU::fdec(_state) != 1) {
+            _state = 0;
+            Futex::wake(&_state);
+        }
+    }
+
+private:
+    volatile int _state;
+};
+
+Futex_Lock lock;
+volatile int counter;
+
+int work()
+{
+    for(int i = 0; i < iterations; i++) {
+        lock.lock();
+        counter = counter + 1;
+        lock.unlock();
+    }
+
+    return 0;
+}
+
+int main()
+{
+    cout << "Futex test" << endl;
+
+    volatile int flag = 1;
+    cout << "wait() on a changed value returns immediately => " << Futex::wait(&flag, 0) << endl;
+    cout << "wake() with no waiters => " << Futex::wake(&flag) << endl;
+
+    Thread * worker[workers];
+    for(int i = 0; i < workers; i++)
+        worker[i] = new Thread(&work);
+
+    for(int i = 0; i < workers; i++) {
+        worker[i]->join();
+        delete worker[i];
+    }
+
+    cout << "counter=" << counter << " (expected " << workers * iterations << ")" << endl;
+
+    return 0;
+}
@@ -0,0 +1,46 @@
+// EPOS Latch Abstraction Implementation
+
+#include <latch.h>
+
+__BEGIN_SYS
+
+Latch::Latch(int count, unsigned int spin): _spin(spin), _count(count)
+{
+    db<Synchronizer>(TRC) << "Latch(count=" << _count << ",spin=" << _spin << ") => " << this << endl;
+}
+
+
+Latch::~Latch()
+{
+    db<Synchronizer>(TRC) << "~Latch(this=" << this << ")" << endl;
+}
+
+
+void Latch::count_down(int n)
+{
+    db<Synchronizer>(TRC) << "Latch::count_down(this=" << this << ",count=" << _count << ",n=" << n << ")" << endl;
+
+    begin_atomic();
+    if((_count > 0) && ((_count -= n) <= 0)) {
+        _count = 0;
+        wakeup_all(); // implicit end_atomic()
+    } else
+        end_atomic();
+}
+
+
+void Latch::wait()
+{
+    db<Synchronizer>(TRC) << "Latch::wait(this=" << this << ",count=" << _count << ")" << endl;
+
+    if(_spin)
+        for(unsigned int i = 0; (i < _spin) && (_count > 0); i++);
+
+    begin_atomic();
+    if(_count > 0)
+        sleep(); // implicit end_atomic()
+    else
+        end_atomic();
+}
+
+__END_SYS
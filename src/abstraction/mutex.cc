@@ -22,9 +22,11 @@ void Mutex::lock()
 
     begin_atomic();
     if(tsl(_locked))
-        sleep(); // implicit end_atomic()
-    else
+        sleep(true); // implicit end_atomic()
+    else {
+        acquired();
         end_atomic();
+    }
 }
 
 
@@ -0,0 +1,63 @@
+// EPOS Periodic Thread Abstraction Test Program
+
+#include <utility/ostream.h>
+#include <periodic_thread.h>
+
+using namespace EPOS;
+
+const int iterations = 50;
+const int period_a = 100000;
+const int period_b = 80000;
+
+int func_a(void);
+int func_b(void);
+
+OStream cout;
+
+int main()
+{
+    cout << "Periodic Thread test" << endl;
+
+    Periodic_Thread * a = new Periodic_Thread(Periodic_Thread::Configuration(period_a, iterations), &func_a);
+    Periodic_Thread * b = new Periodic_Thread(Periodic_Thread::Configuration(period_b, iterations), &func_b);
+
+    a->join();
+    b->join();
+
+    Periodic_Thread * threads[] = { a, b };
+    for(unsigned int i = 0; i < sizeof(threads) / sizeof(Periodic_Thread *); i++) {
+        const Periodic_Thread::Statistics & s = threads[i]->statistics();
+        cout << (char)('A' + i) << ": jobs=" << s.jobs << ", overruns=" << s.overruns
+             << ", jitter(avg/max)=" << s.jitter_average() << "/" << s.jitter_max << " ns"
+             << ", response(avg/max)=" << s.response_average() << "/" << s.response_max << " ns" << endl;
+    }
+
+    delete a;
+    delete b;
+
+    cout << "I'm done, bye!" << endl;
+
+    return 0;
+}
+
+int func_a(void)
+{
+    while(Periodic_Thread::wait_next()) {
+        for(int i = 0; i < 79; i++)
+            cout << "a";
+        cout << endl;
+    }
+
+    return 'A';
+}
+
+int func_b(void)
+{
+    while(Periodic_Thread::wait_next()) {
+        for(int i = 0; i < 79; i++)
+            cout << "b";
+        cout << endl;
+    }
+
+    return 'B';
+}
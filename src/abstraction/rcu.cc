@@ -0,0 +1,131 @@
+// EPOS Read-Copy-Update Abstraction Implementation
+
+#include <rcu.h>
+#include <utility/observer.h>
+
+__BEGIN_SYS
+
+// Class attributes
+volatile unsigned int RCU::_started;
+volatile unsigned int RCU::_completed;
+volatile unsigned int RCU::_pending;
+RCU::List RCU::_next;
+RCU::List RCU::_current;
+RCU::List RCU::_done;
+RCU::Deleters RCU::_deleters;
+
+
+// Class methods
+void RCU::call(Callback * c)
+{
+    db<RCU>(TRC) << "RCU::call(c=" << c << ",h=" << c->_handler << ")" << endl;
+
+    lock();
+
+    _next.insert(&c->_link);
+    if(!running())
+        start();
+
+    unlock();
+
+    reclaim();
+}
+
+
+void RCU::synchronize()
+{
+    db<RCU>(TRC) << "RCU::synchronize()" << endl;
+
+    class Flag: public Handler
+    {
+    public:
+        Flag(): _raised(false) {}
+
+        void operator()() { _raised = true; }
+        bool raised() const { return _raised; }
+
+    private:
+        volatile bool _raised;
+    };
+
+    Flag flag;
+    Callback callback(&flag);
+    call(&callback);
+
+    // Yielding drives this CPU through a quiescent state, the others do it at every quantum
+    while(!flag.raised()) {
+        Thread::yield();
+        reclaim();
+    }
+}
+
+
+void RCU::reclaim()
+{
+    lock();
+
+    while(!_done.empty()) {
+        Callback * c = _done.remove()->object();
+        unlock();
+
+        db<RCU>(INF) << "RCU::reclaim(c=" << c << ")" << endl;
+        (*c->_handler)();
+
+        lock();
+    }
+
+    unlock();
+}
+
+
+// lock() must be held by the callers of start() and quiescent()
+void RCU::start()
+{
+    while(!_next.empty())
+        _current.insert(_next.remove());
+
+    _pending = (1 << Machine::n_cpus()) - 1;
+    _started++;
+
+    db<RCU>(INF) << "RCU::start(gp=" << _started << ")" << endl;
+}
+
+
+void RCU::quiescent(Thread * prev)
+{
+    if(!running() || prev->_rcu_nesting)
+        return;
+
+    _pending &= ~(1 << Machine::cpu_id());
+    if(_pending)
+        return;
+
+    db<RCU>(INF) << "RCU::quiescent(gp=" << _started << ") => grace period elapsed" << endl;
+
+    while(!_current.empty())
+        _done.insert(_current.remove());
+    _completed = _started;
+
+    if(!_next.empty())
+        start();
+}
+
+__END_SYS
+
+// Forwarder to the observers
+__BEGIN_UTIL
+void Observation::rcu_read_lock()
+{
+    RCU::read_lock();
+}
+
+void Observation::rcu_read_unlock()
+{
+    RCU::read_unlock();
+}
+
+void Observation::rcu_synchronize()
+{
+    RCU::synchronize();
+}
+__END_UTIL
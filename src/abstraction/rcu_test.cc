@@ -0,0 +1,81 @@
+// EPOS RCU Abstraction Test Program
+
+#include <utility/ostream.h>
+#include <thread.h>
+#include <rcu.h>
+
+using namespace EPOS;
+
+const int readers = 4;
+const int iterations = 10000;
+const int updates = 100;
+const unsigned int MAGIC = 0xcafebabe;
+
+OStream cout;
+
+struct Configuration {
+    Configuration(int v): version(v), magic(MAGIC) {}
+    ~Configuration() { magic = 0; }
+
+    int version;
+    volatile unsigned int magic;
+};
+
+Configuration * volatile current;
+volatile bool done;
+volatile int errors;
+
+int reader()
+{
+    int last = 0;
+
+    for(int i = 0; !done || (i < iterations); i++) {
+        RCU::read_lock();
+        Configuration * c = current;
+        if((c->magic != MAGIC) || (c->version < last))
+            errors++;
+        last = c->version;
+        RCU::read_unlock();
+    }
+
+    return 0;
+}
+
+int main()
+{
+    cout << "RCU test" << endl;
+
+    current = new Configuration(0);
+
+    Thread * reader_thread[readers];
+    for(int i = 0; i < readers; i++)
+        reader_thread[i] = new Thread(&reader);
+
+    // Half the old versions are freed asynchronously, half after synchronize()
+    for(int i = 1; i <= updates; i++) {
+        Configuration * old = current;
+        current = new Configuration(i);
+        if(i % 2)
+            RCU::free(old);
+        else {
+            RCU::synchronize();
+            delete old;
+        }
+        Thread::yield();
+    }
+    done = true;
+
+    for(int i = 0; i < readers; i++) {
+        reader_thread[i]->join();
+        delete reader_thread[i];
+    }
+
+    RCU::synchronize();
+    RCU::reclaim();
+
+    cout << "version=" << current->version << " (expected " << updates << "), errors=" << errors << endl;
+
+    delete current;
+
+    return 0;
+}
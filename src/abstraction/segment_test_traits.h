@@ -50,11 +50,23 @@ template<> struct Traits<Lists>: public Traits<void>
 template<> struct Traits<Spin>: public Traits<void>
 {
     static const bool debugged = hysterically_debugged;
+    static const bool profiled = false; // see utility/lock_profiler.h
 };
 
 template<> struct Traits<Heaps>: public Traits<void>
 {
     static const bool debugged = hysterically_debugged;
+
+    static const unsigned int SIZE_CLASSES = 8; // 16 to 2048 bytes
+    static const unsigned int SLAB_SIZE = 4096;
+    static const unsigned int MAGAZINE_SIZE = 16; // per CPU and size class (0 disables)
+
+    static const bool statistics = false; // see Heap::stats()
+
+    static const unsigned int GROWTH = 64 * 1024; // minimum growth of multiheap application heaps (0 disables)
+    static const unsigned int REGIONS = 16;       // grown regions tracked for shrinking
+
+    static const bool assert_unlocked = false; // panic on allocations made while Thread::locked() (debugging)
 };
 
 
@@ -143,11 +155,24 @@ template<> struct Traits<Segment>: public Traits<void>
 template<> struct Traits<Alarm>: public Traits<void>
 {
     static const bool visible = hysterically_debugged;
+    static const bool high_resolution = false; // one-shot APIC timers programmed for the nearest alarm deadline (multicore only)
 };
 
 template<> struct Traits<Synchronizer>: public Traits<void>
 {
     static const bool enabled = Traits<System>::multithread;
+    static const bool profiled = false; // see utility/lock_profiler.h
+};
+
+template<> struct Traits<Futex>: public Traits<void>
+{
+    static const bool enabled = Traits<System>::multithread;
+};
+
+template<> struct Traits<RCU>: public Traits<void>
+{
+    static const bool enabled = Traits<System>::multithread;
+    static const unsigned int DELETERS = 64; // free() falls back to the system heap when they run out
 };
 
 __END_SYS
@@ -22,9 +22,11 @@ void Semaphore::p()
 
     begin_atomic();
     if(fdec(_value) < 1)
-        sleep(); // implicit end_atomic()
-    else
+        sleep(true); // implicit end_atomic()
+    else {
+        acquired();
         end_atomic();
+    }
 }
 
 
@@ -4,6 +4,8 @@
 #include <system.h>
 #include <thread.h>
 #include <alarm.h> // for FCFS
+#include <rcu.h>
+#include <futex.h>
 
 // This_Thread class attributes
 __BEGIN_UTIL
@@ -23,13 +25,12 @@ Thread::List Thread::toSuspend[Thread::Criterion::QUEUES];
 // Methods
 void Thread::constructor_prolog(unsigned int stack_size)
 {
+    _stack = new (SYSTEM) char[stack_size]; // before lock(), since the heap must not be used with it held
+
     lock();
 
     _thread_count++;
     _scheduler.insert(this);
-
-
-    _stack = new (SYSTEM) char[stack_size];
 }
 
 
@@ -78,6 +79,9 @@ Thread::~Thread()
     // The running thread cannot delete itself!
     assert(_state != RUNNING);
 
+    // Drop a pending remote suspend, whose link is about to vanish with the thread
+    toSuspend[queue()].remove(this);
+
     switch(_state) {
     case RUNNING:  // For switch completion only: the running thread would have deleted itself! Stack wouldn't have been released!
         exit(-1);
@@ -93,6 +97,8 @@ Thread::~Thread()
         break;
     case WAITING:
         _waiting->remove(this);
+        if(Traits<Futex>::enabled && _futex_waiting)
+            Futex::abandon(this);
         _scheduler.resume(this);
         _scheduler.remove(this);
         _thread_count--;
@@ -189,8 +195,10 @@ void Thread::suspend(bool locked)
 
 		dispatch(prev, next);
     } else {
-    	toSuspend[this->queue()].insert(new (SYSTEM) List::Element(this));
-    	IC::ipi_send(this->queue(), IC::INT_SUSPEND);
+    	if(!toSuspend[this->queue()].search(this)) {
+    		toSuspend[this->queue()].insert(Suspending::element(this));
+    		IC::ipi_send(this->queue(), IC::INT_SUSPEND);
+    	}
     	unlock();
     }
 }
@@ -199,10 +207,12 @@ void Thread::suspend_handler(const IC::Interrupt_Id & i)
 {
 	lock();
 
-	List::Element* e = toSuspend[Machine::cpu_id()].remove_head();
-	Thread* suspend = e->object();
-	delete e;
-	suspend->suspend(true);
+	// The list may be empty if the thread was deleted after the IPI had been sent
+	List::Element * e = toSuspend[Machine::cpu_id()].remove_head();
+	if(e)
+		Suspending::object(e)->suspend(true);
+	else
+		unlock();
 }
 
 
@@ -307,20 +317,23 @@ void Thread::wakeup_all(Queue * q)
     // lock() must be called before entering this method
     assert(locked());
 
-    if(!q->empty())
-        while(!q->empty()) {
-            Thread * t = q->remove()->object();
-            t->_state = READY;
-            t->_waiting = 0;
-            _scheduler.resume(t);
-
-            if(preemptive) {
-                cutucao(t);
-                lock();
-            }
-         }
-    else
-        unlock();
+    // Resume every waiter first and then notify each affected CPU only once,
+    // so releasing n threads costs at most one reschedule IPI per CPU
+    unsigned int cpus = 0;
+    while(!q->empty()) {
+        Thread * t = q->remove()->object();
+        t->_state = READY;
+        t->_waiting = 0;
+        _scheduler.resume(t);
+        cpus |= 1 << t->queue();
+    }
+
+    if(preemptive)
+        for(unsigned int i = 0; i < Criterion::QUEUES; i++)
+            if(cpus & (1 << i))
+                IC::ipi_send(i, IC::INT_RESCHEDULER);
+
+    unlock();
 }
 
 
@@ -332,6 +345,14 @@ void Thread::reschedule()
     assert(locked());
 
     Thread * prev = running();
+
+    // Preemption is deferred to RCU::read_unlock() while prev is inside a read-side critical section
+    if(Traits<RCU>::enabled && prev->_rcu_nesting) {
+        prev->_rcu_deferred = true;
+        unlock();
+        return;
+    }
+
     Thread * next = _scheduler.choose();
 
     dispatch(prev, next);
@@ -409,6 +430,9 @@ void Thread::dispatch(Thread * prev, Thread * next, bool charge)
             _timer->reset();
     }
 
+    if(Traits<RCU>::enabled)
+        RCU::quiescent(prev);
+
     if(prev != next) {
         if(prev->_state == RUNNING)
             prev->_state = READY;
@@ -416,17 +440,18 @@ void Thread::dispatch(Thread * prev, Thread * next, bool charge)
 
         db<Thread>(TRC) << "Thread::dispatch(prev=" << prev << ",next=" << next << ")" << endl;
 
-        // Accounting the runtime.
-        prev->stats.wait_cron_start();
-        prev->stats.runtime_cron_stop();
-        prev->stats.last_runtime(prev->stats.runtime_cron_ticks()); // updating last_runtime + total_runtime
+        // Accounting the runtime. The CPU is looked up once, since each lookup reads the APIC.
+        unsigned int cpu = Machine::cpu_id();
+        prev->stats.wait_cron_start(cpu);
+        prev->stats.runtime_cron_stop(cpu);
+        prev->stats.last_runtime(prev->stats.runtime_cron_ticks(), cpu); // updating last_runtime + total_runtime
 
-        next->stats.wait_cron_stop();
+        next->stats.wait_cron_stop(cpu);
         if(next->criterion() != IDLE) {
         	next->link()->rank(Criterion(next->stats.wait_history_media(), next->queue()));
         }
 
-        next->stats.runtime_cron_start();
+        next->stats.runtime_cron_start(cpu);
 
         db<Thread>(TRC) << "[prev!=next] TID: " << prev << " | Wait Media: " << prev->stats.wait_history_media() << " | Runtime Media: " << 
             prev->stats.runtime_history_media() << " | State: " << prev->_state << endl;
@@ -449,7 +474,15 @@ int Thread::idle()
         if(Traits<Thread>::trace_idle)
             db<Thread>(TRC) << "Thread::idle(CPU=" << Machine::cpu_id() << ",this=" << running() << ")" << endl;
 
+        if(Traits<RCU>::enabled)
+            RCU::reclaim();
+
         CPU::int_enable();
+
+        // Refill the pool of pre-zeroed frames for MMU::calloc() before halting
+        if(Traits<MMU>::ZEROED_FRAMES)
+            while((_thread_count > Machine::n_cpus()) && MMU::zero());
+
         CPU::halt();
     }
 
@@ -474,10 +507,20 @@ int Thread::idle()
 
 __END_SYS
 
-// Id forwarder to the spin lock
+// Forwarders to the spin lock and to the heap
 __BEGIN_UTIL
 unsigned int This_Thread::id()
 {
     return _not_booting ? reinterpret_cast<volatile unsigned int>(Thread::self()) : Machine::cpu_id() + 1;
 }
+
+bool This_Thread::locked()
+{
+    return _not_booting && Thread::locked();
+}
+
+unsigned int This_CPU::id()
+{
+    return Machine::cpu_id();
+}
 __END_UTIL
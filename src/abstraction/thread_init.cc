@@ -8,6 +8,8 @@ __BEGIN_SYS
 
 void Thread::init()
 {
+    _lock.name("Thread::_lock");
+
     // The installation of the scheduler timer handler must precede the
     // creation of threads, since the constructor can induce a reschedule
     // and this in turn can call timer->reset()
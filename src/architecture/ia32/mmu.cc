@@ -5,7 +5,10 @@
 __BEGIN_SYS
 
 // Class attributes
-IA32_MMU::List IA32_MMU::_free;
+IA32_MMU::Free_List IA32_MMU::_free[IA32_MMU::ORDERS];
+IA32_MMU::Free_List IA32_MMU::_zeroed;
+IA32_MMU::Free_Map IA32_MMU::_map;
+Spin IA32_MMU::_lock;
 IA32_MMU::Page_Directory * IA32_MMU::_master;
 
 __END_SYS
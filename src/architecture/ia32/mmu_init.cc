@@ -28,8 +28,8 @@ void IA32_MMU::init()
     
     // BIG WARING HERE: INIT (i.e. this program) will be part of the free
     // storage after the following is executed, but it will remain alive
-    // This only works because the _free.insert_merging() only
-    // touchs the first page of each chunk and INIT is not there
+    // This only works because release() only touches the first frame of
+    // each buddy block (the list element) and INIT is not there
 
     // Insert all free memory into the _free list
     free(si->pmm.free1_base, pages(si->pmm.free1_top - si->pmm.free1_base));
@@ -26,6 +26,8 @@ public:
 				char * stack = MMU::align_page(&_end);
 				char * heap = stack + MMU::align_page(Traits<Application>::STACK_SIZE);
 				Application::_heap = new (&Application::_preheap[0]) Heap(heap, HEAP_SIZE);
+				if(Traits<Heaps>::GROWTH)
+					Application::_heap->grower(&Application::grow, &Application::shrink);
 			} else
 				for(unsigned int frames = MMU::allocable(); frames; frames = MMU::allocable())
 					System::_heap->free(MMU::alloc(frames), frames * sizeof(MMU::Page));
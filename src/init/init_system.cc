@@ -5,6 +5,7 @@
 #include <system.h>
 #include <address_space.h>
 #include <segment.h>
+#include <clock.h>
 
 __BEGIN_SYS
 
@@ -42,6 +43,10 @@ public:
 
 			Machine::smp_barrier();
 
+			// Synchronize the time stamps of all CPUs
+			if(Traits<TSC>::enabled)
+				Clock::init();
+
 			// Initialize system abstractions
 			db<Init>(INF) << "Initializing system abstractions: " << endl;
 			System::init();
@@ -59,6 +64,8 @@ public:
 			}
         }else {
         	Machine::smp_barrier();
+        	if(Traits<TSC>::enabled)
+        		Clock::init();
         	Timer::init();
         }
 
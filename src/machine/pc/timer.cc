@@ -7,31 +7,104 @@
 __BEGIN_SYS
 
 // Class attributes
-PC_Timer * PC_Timer::_channels[CHANNELS];
+PC_Timer * volatile PC_Timer::_channels[CHANNELS];
+PC_Timer::Multiplexer PC_Timer::_mux[Traits<Machine>::CPUS];
+volatile PC_Timer::Time_Stamp PC_Timer::_next_tick[Traits<Machine>::CPUS];
+volatile PC_Timer::Time_Stamp PC_Timer::_deadline[Traits<Machine>::CPUS];
+PC_Timer::Handler PC_Timer::_deadline_handler;
 
 // Class methods
+void PC_Timer::deadline(const Time_Stamp & ts)
+{
+    if(!high_resolution)
+        return;
+
+    unsigned int cpu = Machine::cpu_id();
+    if(!_deadline[cpu] || (ts < _deadline[cpu])) {
+        _deadline[cpu] = ts;
+        program(cpu);
+    }
+}
+
+
 void PC_Timer::int_handler(const Interrupt_Id & i)
 {
+    unsigned int cpu = Machine::cpu_id();
 
-    if(_channels[SCHEDULER] && (--_channels[SCHEDULER]->_current[Machine::cpu_id()] <= 0)) {
-        _channels[SCHEDULER]->_current[Machine::cpu_id()] = _channels[SCHEDULER]->_initial;
-        _channels[SCHEDULER]->_handler(i);
+    if(!high_resolution) {
+        if(_mux[cpu].tick())
+            channels(i, cpu);
+        return;
     }
 
-    if((!Traits<System>::multicore || (Traits<System>::multicore && (Machine::cpu_id() == 0))) && _channels[ALARM]) {
-        _channels[ALARM]->_current[0] = _channels[ALARM]->_initial;
-        _channels[ALARM]->_handler(i);
+    Time_Stamp now = TSC::time_stamp();
+
+    // Ticks missed while interrupts were disabled are dropped, as they would be with a periodic timer
+    if(now >= _next_tick[cpu]) {
+        while(_next_tick[cpu] <= now)
+            _next_tick[cpu] += tick();
+        if(_mux[cpu].tick())
+            channels(i, cpu);
     }
 
-    if(_channels[REBALANCER] && (--_channels[REBALANCER]->_current[Machine::cpu_id()] <= 0)){
-    	_channels[REBALANCER]->_current[Machine::cpu_id()] = _channels[REBALANCER]->_initial;
-    	_channels[REBALANCER]->_handler(i);
+    if(_deadline[cpu] && (_deadline[cpu] <= now)) {
+        _deadline[cpu] = 0;
+        if(_deadline_handler)
+            _deadline_handler(i);
     }
 
-    if((!Traits<System>::multicore || (Traits<System>::multicore && (Machine::cpu_id() == 0))) && _channels[USER]) {
-        if(_channels[USER]->_retrigger)
-            _channels[USER]->_current[0] = _channels[USER]->_initial;
-        _channels[USER]->_handler(i);
+    program(cpu);
+}
+
+
+// Programs the one-shot timer of this CPU for its next tick or deadline
+void PC_Timer::program(unsigned int cpu)
+{
+    Time_Stamp next = _next_tick[cpu];
+    if(_deadline[cpu] && (_deadline[cpu] < next))
+        next = _deadline[cpu];
+
+    Time_Stamp now = TSC::time_stamp();
+    Count count = (next > now) ? (next - now) * Engine::clock() / TSC::frequency() : 0;
+    if(count < MIN_COUNT)
+        count = MIN_COUNT;
+
+    Engine::config(0, count, true, false);
+}
+
+
+// Runs the handlers of the channels due at this tick on this CPU. A handler may switch to another thread, and this
+// CPU may take further timer interrupts before it returns, so the heap is consistent before each call. Channels of
+// timers removed in the meantime are dropped. Alarms are kept in per-CPU queues (see Alarm::handler()), so every CPU
+// ticks them; the user timer only runs on CPU 0.
+void PC_Timer::channels(const Interrupt_Id & i, unsigned int cpu)
+{
+    Multiplexer * mux = &_mux[cpu];
+
+    if(mux->validate())
+        rebuild(cpu);
+
+    for(int channel; (channel = mux->expired()) >= 0; ) {
+        PC_Timer * timer = _channels[channel];
+        if(!timer)
+            continue;
+        if(timer->_retrigger)
+            mux->insert(channel, timer->_initial);
+        timer->_handler(i);
+    }
+}
+
+
+// Puts every installed channel in the heap of this CPU, each due one period from now
+void PC_Timer::rebuild(unsigned int cpu)
+{
+    Multiplexer * mux = &_mux[cpu];
+
+    mux->clear();
+    for(unsigned int c = 0; c < CHANNELS; c++) {
+        PC_Timer * timer = _channels[c];
+        if(timer && ((c != USER) || !Traits<System>::multicore || (cpu == 0)))
+            mux->insert(c, timer->_initial);
     }
 }
 
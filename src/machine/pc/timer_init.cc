@@ -1,5 +1,6 @@
 // EPOS PC Timer Mediator Initialization
 
+#include <machine.h>
 #include <timer.h>
 #include <ic.h>
 
@@ -11,7 +12,11 @@ void PC_Timer::init()
 
     //CPU::int_disable();
     
-    Engine::config(0, Engine::clock() / FREQUENCY);
+    if(high_resolution) {
+        _next_tick[Machine::cpu_id()] = TSC::time_stamp() + tick();
+        Engine::config(0, Engine::clock() / FREQUENCY, true, false);
+    } else
+        Engine::config(0, Engine::clock() / FREQUENCY);
 
     IC::int_vector(IC::INT_TIMER, int_handler);
     IC::enable(IC::INT_TIMER);
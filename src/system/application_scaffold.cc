@@ -2,6 +2,8 @@
 
 #include <utility/ostream.h>
 #include <application.h>
+#include <address_space.h>
+#include <system.h>
 
 __BEGIN_SYS
 
@@ -9,6 +11,38 @@ __BEGIN_SYS
 char Application::_preheap[];
 Heap * Application::_heap;
 
+
+// Application class methods
+// The application heap grows by mapping new segments into the current address space
+void * Application::grow(unsigned int * bytes, void ** segment)
+{
+    Segment * seg = new (SYSTEM) Segment(*bytes, Segment::Flags::APP);
+
+    void * addr = Address_Space(MMU::current()).attach(seg);
+
+    db<Application>(INF) << "Application::grow(bytes=" << seg->size() << ",seg=" << seg << ") => " << addr << endl;
+
+    if(!addr) {
+        delete seg;
+        return 0;
+    }
+
+    *bytes = seg->size();
+    *segment = seg;
+
+    return addr;
+}
+
+void Application::shrink(void * addr, unsigned int bytes, void * segment)
+{
+    Segment * seg = reinterpret_cast<Segment *>(segment);
+
+    db<Application>(INF) << "Application::shrink(addr=" << addr << ",bytes=" << bytes << ",seg=" << seg << ")" << endl;
+
+    Address_Space(MMU::current()).detach(seg, addr);
+    delete seg;
+}
+
 __END_SYS
 
 __BEGIN_API
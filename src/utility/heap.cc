@@ -7,10 +7,93 @@ extern "C" { void _panic(); }
 __BEGIN_UTIL
 
 // Methods
+Heap::Statistics Heap::stats()
+{
+    Statistics s;
+
+    s.in_use = _in_use;
+    s.peak = _peak;
+    for(unsigned int i = 0; i <= CLASSES; i++) {
+        s.allocs[i] = _allocs[i];
+        s.frees[i] = _frees[i];
+    }
+
+    bool ints = acquire();
+
+    s.free = _index.free_bytes();
+    s.blocks = _index.blocks();
+    s.largest = _index.largest();
+    unsigned int indexed = s.free;
+
+    // Magazines of other CPUs are read without their owners' cooperation, so their counts are approximate
+    for(unsigned int i = 0; i < CLASSES; i++) {
+        unsigned int n = 0;
+        for(Block * b = _class[i]; b; b = b->next)
+            n++;
+        for(unsigned int j = 0; j < CPUS; j++)
+            n += _magazine[j][i].count;
+
+        s.free += n * (MIN_CLASS << i);
+        s.blocks += n;
+        if(n && ((MIN_CLASS << i) > s.largest))
+            s.largest = MIN_CLASS << i;
+    }
+
+    release(ints);
+
+    // Fragmentation of the TLSF index: how far its largest block is from all of its free memory
+    s.fragmentation = (indexed > s.largest) ? 100 - s.largest / ((indexed + 99) / 100) : 0;
+
+    return s;
+}
+
+
+void Heap::dump(OStream & os)
+{
+    Statistics s = stats();
+
+    bool ints = acquire();
+
+    os << "Heap::dump(this=" << this << ")" << endl;
+    os << "free index:";
+    _index.dump(os);
+    os << endl;
+
+    for(unsigned int i = 0; i < CLASSES; i++) {
+        unsigned int n = 0;
+        for(Block * b = _class[i]; b; b = b->next)
+            n++;
+        os << "class " << (MIN_CLASS << i) << ": " << n << " free";
+        if(cached) {
+            os << ", magazines={";
+            for(unsigned int j = 0; j < CPUS; j++)
+                os << _magazine[j][i].count << ((j < CPUS - 1) ? "," : "");
+            os << "}";
+        }
+        os << endl;
+    }
+
+    release(ints);
+
+    os << "stats=" << s << endl;
+}
+
+
 void Heap::out_of_memory()
 {
     db<Heaps>(ERR) << "Heap::alloc(this=" << this << "): out of memory!" << endl;
 
+    if(statistics)
+        db<Heaps>(ERR) << "Heap::stats() => " << stats() << endl;
+
+    _panic();
+}
+
+
+void Heap::locked()
+{
+    db<Heaps>(ERR) << "Heap(this=" << this << "): used while Thread::locked()!" << endl;
+
     _panic();
 }
 
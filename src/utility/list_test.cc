@@ -15,6 +15,7 @@ void test_relative_list();
 void test_grouping_list();
 void test_simple_grouping_list();
 void test_scheduling_list();
+void test_intrusive();
 
 OStream cout;
 
@@ -29,6 +30,7 @@ int main()
     test_relative_list();
     test_grouping_list();
     test_scheduling_list();
+    test_intrusive();
 
     cout << "\nDone!" << endl;
 
@@ -471,3 +473,42 @@ void test_scheduling_list ()
     for(int i = 0; i < N; i++)
         delete e[i];
 }
+
+// An object that embeds the element that links it, after some other member
+class Node
+{
+public:
+    Node(int i): _link(this), _value(i) {}
+
+    int value() const { return _value; }
+
+    Simple_List<Node>::Element _link;
+
+private:
+    int _value;
+};
+
+void test_intrusive()
+{
+    typedef Intrusive<Node, Simple_List<Node>::Element, &Node::_link> Linked;
+
+    cout << "\nThis is a singly-linked list of objects that embed their elements:" << endl;
+    Simple_List<Node> l;
+    Node n[N] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    cout << "Inserting the nodes through their embedded elements" << endl;
+    for(int i = 0; i < N; i++)
+        l.insert(Linked::element(&n[i]));
+    cout << "Reaching the nodes back from their elements => ";
+    int errors = 0;
+    for(Simple_List<Node>::Element * e = l.head(); e; e = e->next()) {
+        cout << Linked::object(e)->value();
+        if(Linked::object(e) != e->object())
+            errors++;
+        if(e->next())
+            cout << ", ";
+    }
+    cout << endl;
+    cout << "Mismatches => " << errors << " (expected 0)" << endl;
+    while(l.size() > 0)
+        l.remove_head();
+}
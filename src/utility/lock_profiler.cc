@@ -0,0 +1,11 @@
+// EPOS Lock Contention Profiler Utility Implementation
+
+#include <utility/lock_profiler.h>
+
+__BEGIN_UTIL
+
+// Class attributes
+Lock_Profile<true> * Lock_Profiler::_head;
+volatile bool Lock_Profiler::_lock;
+
+__END_UTIL
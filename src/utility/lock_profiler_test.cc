@@ -0,0 +1,57 @@
+// EPOS Lock Contention Profiler Utility Test Program
+
+#include <utility/ostream.h>
+#include <utility/lock_profiler.h>
+#include <thread.h>
+#include <mutex.h>
+
+using namespace EPOS;
+
+const int workers = 4;
+const int iterations = 1000;
+
+OStream cout;
+
+Mutex hot;
+Mutex cold;
+
+int work(int n)
+{
+    for(int i = 0; i < iterations; i++) {
+        hot.lock();
+        for(volatile int j = 0; j < 100; j++);
+        hot.unlock();
+
+        if(!(i % 100)) {
+            cold.lock();
+            cold.unlock();
+        }
+    }
+
+    return n;
+}
+
+int main()
+{
+    cout << "Lock Contention Profiler test" << endl;
+
+    if(!Traits<Synchronizer>::profiled && !Traits<Spin>::profiled)
+        cout << "Profiling is disabled (see Traits<Synchronizer>::profiled and Traits<Spin>::profiled)!" << endl;
+
+    hot.name("hot");
+    cold.name("cold");
+
+    Thread * worker[workers];
+    for(int i = 0; i < workers; i++)
+        worker[i] = new Thread(&work, i);
+
+    for(int i = 0; i < workers; i++) {
+        worker[i]->join();
+        delete worker[i];
+    }
+
+    cout << Lock_Profiler::size() << " locks registered" << endl;
+    Lock_Profiler::dump(cout, 5);
+
+    return 0;
+}
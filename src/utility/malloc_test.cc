@@ -38,6 +38,59 @@ int main()
     strcpy(sp, "string");
     cout << "new char[1024]\t\t=> {p=" << (void *)sp << ",v=" << sp << "}" << endl;
 
-    
+    cout << "size classes: a freed small block must be the next one handed out" << endl;
+    const int sizes[] = { 1, 20, 100, 500, 2000, 5000 };
+    for(unsigned int i = 0; i < sizeof(sizes) / sizeof(int); i++) {
+        void * p = malloc(sizes[i]);
+        free(p);
+        void * q = malloc(sizes[i]);
+        cout << "malloc(" << sizes[i] << ")\t\t=> {p=" << p << ",reused=" << (p == q) << "}" << endl;
+        free(q);
+    }
+
+    cout << "aligned allocation: addresses must be multiples of the alignment" << endl;
+    for(unsigned int align = 8; align <= 4096; align <<= 3) {
+        void * p = memalign(align, 100);
+        cout << "memalign(" << align << ",100)\t=> {p=" << p << ",aligned=" << !(reinterpret_cast<unsigned int>(p) % align) << "}" << endl;
+        free(p);
+    }
+    void * ap;
+    int r = posix_memalign(&ap, 64, 5000);
+    cout << "posix_memalign(64,5000)\t=> {r=" << r << ",p=" << ap << ",aligned=" << !(reinterpret_cast<unsigned int>(ap) % 64) << "}" << endl;
+    cout << "posix_memalign(24,10)\t=> {r=" << posix_memalign(&ap, 24, 10) << "} (expected 22)" << endl;
+
+    cout << "realloc: a large block followed by free memory must grow in place" << endl;
+    char * bp = reinterpret_cast<char *>(malloc(5000));
+    strcpy(bp, "growing");
+    char * gp = reinterpret_cast<char *>(realloc(bp, 10000));
+    cout << "realloc(5000->10000)\t=> {p=" << (void *)gp << ",in place=" << (gp == bp) << ",v=" << gp << "}" << endl;
+    gp = reinterpret_cast<char *>(realloc(gp, 3000));
+    cout << "realloc(10000->3000)\t=> {in place=" << (gp == bp) << ",v=" << gp << "}" << endl;
+    char * tp = reinterpret_cast<char *>(malloc(10));
+    strcpy(tp, "tiny");
+    char * up = reinterpret_cast<char *>(realloc(tp, 12));
+    cout << "realloc(10->12)\t\t=> {in place=" << (up == tp) << ",v=" << up << "}" << endl;
+    up = reinterpret_cast<char *>(realloc(up, 3000));
+    cout << "realloc(12->3000)\t=> {moved=" << (up != tp) << ",v=" << up << "}" << endl;
+    free(up);
+    free(gp);
+    free(ap);
+
+    cout << "batch allocation" << endl;
+    void * batch[32];
+    unsigned int n = malloc_batch(32, 40, batch);
+    bool distinct = true;
+    for(unsigned int i = 1; i < n; i++)
+        if(batch[i] == batch[i - 1])
+            distinct = false;
+    cout << "malloc_batch(32,40)\t=> {n=" << n << ",distinct=" << distinct << "}" << endl;
+    free_batch(n, batch);
+
+    Heap * heap = Traits<System>::multiheap ? Application::heap() : System::heap();
+    if(Traits<Heaps>::statistics)
+        heap->dump(cout);
+    else
+        cout << "Heap statistics are disabled (see Traits<Heaps>::statistics)!" << endl;
+
     return 0;
 }
@@ -0,0 +1,66 @@
+// EPOS Object Pool and Arena Utility Test Program
+
+#include <utility/ostream.h>
+#include <utility/pool.h>
+
+using namespace EPOS;
+
+const unsigned int OBJECTS = 8;
+
+OStream cout;
+
+class Object
+{
+public:
+    Object(int i): _i(i) { live++; }
+    ~Object() { live--; }
+
+    int i() const { return _i; }
+
+    static int live;
+
+private:
+    int _i;
+};
+
+int Object::live;
+
+Pool<Object, OBJECTS> pool;
+Pool<Object, OBJECTS, true> cached_pool;
+
+char buffer[256];
+Arena arena(buffer, sizeof(buffer));
+
+int main()
+{
+    cout << "Pool and Arena test" << endl;
+
+    Object * o[OBJECTS + 1];
+    for(unsigned int i = 0; i <= OBJECTS; i++)
+        o[i] = new (pool) Object(i);
+    cout << "Pool: " << OBJECTS << " objects allocated, the next one => " << o[OBJECTS] << " (expected 0)" << endl;
+    cout << "Pool: available=" << pool.available() << ", live=" << Object::live << endl;
+
+    Object * first = o[0];
+    for(unsigned int i = 0; i < OBJECTS; i++)
+        pool.destroy(o[i]);
+    cout << "Pool: available=" << pool.available() << ", live=" << Object::live << endl;
+    o[0] = new (pool) Object(0);
+    cout << "Pool: slots are reused => " << (o[0] == first) << endl;
+    pool.destroy(o[0]);
+
+    for(unsigned int i = 0; i < OBJECTS; i++)
+        o[i] = new (cached_pool) Object(i);
+    for(unsigned int i = 0; i < OBJECTS; i++)
+        cached_pool.destroy(o[i]);
+    cout << "Cached pool: available=" << cached_pool.available() << ", live=" << Object::live << endl;
+
+    int * v = new (arena) int[16];
+    Object * a = new (arena) Object(42);
+    cout << "Arena: v=" << v << ", a=" << a << ", a->i()=" << a->i() << ", used=" << arena.used() << endl;
+    a->~Object();
+    arena.reset();
+    cout << "Arena: after reset, used=" << arena.used() << ", next alloc reuses the base => " << (new (arena) int(0) == v) << endl;
+
+    return 0;
+}
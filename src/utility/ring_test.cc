@@ -0,0 +1,81 @@
+// EPOS Lock-free Ring Utility Test Program
+
+#include <utility/ostream.h>
+#include <utility/ring.h>
+#include <thread.h>
+#include <semaphore.h>
+
+using namespace EPOS;
+
+const int iterations = 1000;
+
+OStream cout;
+
+Blocking_Queue<SPSC_Ring<int, 16>, Semaphore> pipe;
+Blocking_Queue<MPMC_Queue<int, 16>, Semaphore> shared;
+
+int producer(int n)
+{
+    for(int i = 0; i < iterations; i++)
+        shared.insert(n * iterations + i);
+
+    return 0;
+}
+
+int consumer()
+{
+    int sum = 0;
+    for(int i = 0; i < iterations; i++)
+        sum += pipe.remove();
+
+    return sum;
+}
+
+int main()
+{
+    cout << "Lock-free Ring Utility Test" << endl;
+
+    cout << "\nThis is a single-producer, single-consumer ring of 4 integers:" << endl;
+    SPSC_Ring<int, 4> ring;
+    for(int i = 0; i < 5; i++)
+        cout << "Inserting " << i << " => " << ring.insert(i) << endl;
+    cout << "The ring has now " << ring.size() << " elements (full=" << ring.full() << ")." << endl;
+    int o;
+    while(ring.remove(&o))
+        cout << "Removed " << o << endl;
+    cout << "The ring has now " << ring.size() << " elements (empty=" << ring.empty() << ")." << endl;
+
+    cout << "\nThis is a multi-producer, multi-consumer queue of 4 integers:" << endl;
+    MPMC_Queue<int, 4> queue;
+    for(int i = 0; i < 5; i++)
+        cout << "Inserting " << i << " => " << queue.insert(i) << endl;
+    while(queue.remove(&o))
+        cout << "Removed " << o << endl;
+    cout << "The queue has now " << queue.size() << " elements." << endl;
+
+    cout << "\nPipelining " << iterations << " integers through a blocking ring:" << endl;
+    Thread * cons = new Thread(&consumer);
+    int expected = 0;
+    for(int i = 0; i < iterations; i++) {
+        pipe.insert(i);
+        expected += i;
+    }
+    int sum = cons->join();
+    cout << "sum=" << sum << " (expected " << expected << ")" << endl;
+    delete cons;
+
+    cout << "\nMerging two producers through a blocking MPMC queue:" << endl;
+    Thread * prod[2];
+    for(int i = 0; i < 2; i++)
+        prod[i] = new Thread(&producer, i);
+    sum = 0;
+    for(int i = 0; i < 2 * iterations; i++)
+        sum += shared.remove();
+    for(int i = 0; i < 2; i++) {
+        prod[i]->join();
+        delete prod[i];
+    }
+    cout << "sum=" << sum << " (expected " << (2 * expected + iterations * iterations) << ")" << endl;
+
+    return 0;
+}
@@ -0,0 +1,66 @@
+// EPOS TLSF Utility Test Program
+
+#include <utility/ostream.h>
+#include <utility/random.h>
+#include <utility/tlsf.h>
+
+using namespace EPOS;
+
+const unsigned int BLOCKS = 64;
+const unsigned int ITERATIONS = 10000;
+
+OStream cout;
+
+char memory[64 * 1024];
+TLSF tlsf;
+
+int main()
+{
+    cout << "TLSF test" << endl;
+
+    tlsf.insert(memory, sizeof(memory));
+    unsigned int total = tlsf.free_bytes();
+    cout << "free=" << total << ", blocks=" << tlsf.blocks() << ", largest=" << tlsf.largest() << endl;
+
+    char * block[BLOCKS];
+    for(unsigned int i = 0; i < BLOCKS; i++)
+        block[i] = 0;
+
+    // A third of the allocations is aligned and a third of the operations on live blocks resizes them
+    unsigned int failed = 0, misaligned = 0, resized = 0;
+    for(unsigned int i = 0; i < ITERATIONS; i++) {
+        unsigned int j = Random::random() % BLOCKS;
+        if(block[j]) {
+            if(!(Random::random() % 3)) {
+                if(tlsf.resize(block[j], Random::random() % 4096 + 1))
+                    resized++;
+            } else {
+                tlsf.free(block[j]);
+                block[j] = 0;
+            }
+        } else if(!(Random::random() % 3)) {
+            unsigned int align = 8 << (Random::random() % 7);
+            block[j] = reinterpret_cast<char *>(tlsf.alloc(Random::random() % 2048 + 1, align, 0));
+            if(!block[j])
+                failed++;
+            else if(reinterpret_cast<unsigned int>(block[j]) % align)
+                misaligned++;
+        } else {
+            block[j] = reinterpret_cast<char *>(tlsf.alloc(Random::random() % 2048 + 1));
+            if(!block[j])
+                failed++;
+        }
+    }
+    cout << "after " << ITERATIONS << " operations: free=" << tlsf.free_bytes() << ", blocks=" << tlsf.blocks() << ", failed=" << failed
+         << ", resized in place=" << resized << ", misaligned=" << misaligned << " (expected 0)" << endl;
+    tlsf.dump(cout);
+    cout << endl;
+
+    for(unsigned int i = 0; i < BLOCKS; i++)
+        if(block[i])
+            tlsf.free(block[i]);
+
+    cout << "all freed: free=" << tlsf.free_bytes() << " (expected " << total << "), blocks=" << tlsf.blocks() << " (expected 1)" << endl;
+
+    return 0;
+}
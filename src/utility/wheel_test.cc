@@ -0,0 +1,64 @@
+// EPOS Timing Wheel Utility Test Program
+
+#include <utility/ostream.h>
+#include <utility/random.h>
+#include <utility/wheel.h>
+
+using namespace EPOS;
+
+const unsigned int TIMEOUTS = 256;
+const unsigned int TICKS = 100000;
+
+struct Timeout;
+typedef Timing_Wheel<Timeout> Wheel;
+
+struct Timeout {
+    Timeout(): link(this), when(0), pending(false) {}
+
+    Wheel::Element link;
+    unsigned int when;
+    bool pending;
+};
+
+OStream cout;
+
+Wheel wheel;
+Timeout timeout[TIMEOUTS];
+
+int main()
+{
+    cout << "Timing Wheel test" << endl;
+
+    // Timeouts are armed with delays from one tick to beyond the wheel's span and
+    // one in four is cancelled; each must expire exactly at the tick it was set to
+    unsigned int armed = 0, cancelled = 0, expired = 0, wrong = 0;
+    for(unsigned int t = 0; t < TICKS; t++) {
+        Timeout * o = &timeout[Random::random() % TIMEOUTS];
+        if(o->pending) {
+            if(!(Random::random() % 4)) {
+                wheel.remove(&o->link);
+                o->pending = false;
+                cancelled++;
+            }
+        } else {
+            unsigned int ticks = (Random::random() % 8) ? Random::random() % 1000 + 1 : Random::random() % (1 << 25) + 1;
+            wheel.insert(&o->link, ticks);
+            o->when = wheel.now() + ticks;
+            o->pending = true;
+            armed++;
+        }
+
+        wheel.tick();
+
+        for(Wheel::Element * e; (e = wheel.expired()); expired++) {
+            if(!e->object()->pending || (e->object()->when != wheel.now()))
+                wrong++;
+            e->object()->pending = false;
+        }
+    }
+
+    cout << "armed=" << armed << ", cancelled=" << cancelled << ", expired=" << expired
+         << ", pending=" << wheel.size() << ", wrong=" << wrong << " (expected 0)" << endl;
+
+    return 0;
+}